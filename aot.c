@@ -0,0 +1,219 @@
+#include "aot.h"
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Section header indices of the object file
+enum {
+    SEC_NULL,
+    SEC_TEXT,
+    SEC_DATA,       // Helper address table, one pointer per JitHelper
+    SEC_RELA_TEXT,
+    SEC_RELA_DATA,
+    SEC_SYMTAB,
+    SEC_STRTAB,
+    SEC_NOTE_STACK, // Empty .note.GNU-stack: the code needs no executable stack
+    SEC_SHSTRTAB,
+    SEC_COUNT
+};
+
+// Growable byte buffer
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t cap;
+    int failed;
+} Buf;
+
+static size_t buf_append(Buf *b, const void *p, size_t n) {
+    size_t at = b->size;
+    if (b->size + n > b->cap) {
+        size_t cap = b->cap ? b->cap : 256;
+        while (cap < b->size + n) cap *= 2;
+        uint8_t *data = realloc(b->data, cap);
+        if (!data) {
+            b->failed = 1;
+            return at;
+        }
+        b->data = data;
+        b->cap = cap;
+    }
+    if (p) memcpy(b->data + b->size, p, n);
+    else memset(b->data + b->size, 0, n);
+    b->size += n;
+    return at;
+}
+
+static void buf_align(Buf *b, size_t align) {
+    if (b->size % align) buf_append(b, NULL, align - b->size % align);
+}
+
+// Add a NUL-terminated string to a string table, returning its offset
+static uint32_t str_add(Buf *b, const char *s) {
+    return (uint32_t)buf_append(b, s, strlen(s) + 1);
+}
+
+static void add_sym(Buf *symtab, uint32_t name, int bind, int type, int shndx, uint64_t value, uint64_t size) {
+    Elf64_Sym sym = {
+        .st_name = name,
+        .st_info = ELF64_ST_INFO(bind, type),
+        .st_shndx = (Elf64_Section)shndx,
+        .st_value = value,
+        .st_size = size,
+    };
+    buf_append(symtab, &sym, sizeof(sym));
+}
+
+int aot_write_object(const JitObject *obj, const char *entry, const char *path) {
+    Buf file = { 0 }, symtab = { 0 }, strtab = { 0 }, shstrtab = { 0 };
+    Buf rela_text = { 0 }, rela_data = { 0 };
+    Elf64_Shdr sh[SEC_COUNT];
+    memset(sh, 0, sizeof(sh));
+
+    // Symbols: locals first (sections, functions, labels), then the globals
+    str_add(&strtab, "");
+    add_sym(&symtab, 0, STB_LOCAL, STT_NOTYPE, SHN_UNDEF, 0, 0);
+    add_sym(&symtab, 0, STB_LOCAL, STT_SECTION, SEC_TEXT, 0, 0);
+    int data_sym = 2;
+    add_sym(&symtab, 0, STB_LOCAL, STT_SECTION, SEC_DATA, 0, 0);
+    uint64_t entry_size = 0;
+    for (int i = 0; i < obj->nsyms; i++) {
+        const JitSymbol *s = &obj->syms[i];
+        add_sym(&symtab, str_add(&strtab, s->name), STB_LOCAL, s->is_function ? STT_FUNC : STT_NOTYPE,
+                SEC_TEXT, s->offset, s->size);
+        if (s->is_function && s->offset == 0) entry_size = s->size;
+    }
+    int first_global = (int)(symtab.size / sizeof(Elf64_Sym));
+    add_sym(&symtab, str_add(&strtab, entry), STB_GLOBAL, STT_FUNC, SEC_TEXT, 0, entry_size);
+    int helper_sym = first_global + 1;
+    for (int h = 0; h < JIT_HELPER_COUNT; h++) {
+        add_sym(&symtab, str_add(&strtab, jit_helper_symbols[h]), STB_GLOBAL, STT_NOTYPE, SHN_UNDEF, 0, 0);
+    }
+
+    // Code reads helpers[h] rip-relatively; the table holds absolute helper addresses
+    for (int i = 0; i < obj->nrelocs; i++) {
+        Elf64_Rela r = {
+            .r_offset = obj->relocs[i].offset,
+            .r_info = ELF64_R_INFO(data_sym, R_X86_64_PC32),
+            .r_addend = (int64_t)obj->relocs[i].helper * 8 - 4,
+        };
+        buf_append(&rela_text, &r, sizeof(r));
+    }
+    for (int h = 0; h < JIT_HELPER_COUNT; h++) {
+        Elf64_Rela r = {
+            .r_offset = (uint64_t)h * 8,
+            .r_info = ELF64_R_INFO(helper_sym + h, R_X86_64_64),
+            .r_addend = 0,
+        };
+        buf_append(&rela_data, &r, sizeof(r));
+    }
+
+    // Layout: ELF header, section contents, section headers
+    static const char *names[SEC_COUNT] = {
+        "", ".text", ".data", ".rela.text", ".rela.data", ".symtab", ".strtab",
+        ".note.GNU-stack", ".shstrtab",
+    };
+    for (int i = 0; i < SEC_COUNT; i++) sh[i].sh_name = str_add(&shstrtab, names[i]);
+
+    buf_append(&file, NULL, sizeof(Elf64_Ehdr));
+    struct { int sec; const void *data; size_t size; uint32_t type; uint64_t flags; size_t align; } parts[] = {
+        { SEC_TEXT, obj->code, obj->size, SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, 16 },
+        { SEC_DATA, NULL, JIT_HELPER_COUNT * 8, SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, 8 },
+        { SEC_RELA_TEXT, rela_text.data, rela_text.size, SHT_RELA, SHF_INFO_LINK, 8 },
+        { SEC_RELA_DATA, rela_data.data, rela_data.size, SHT_RELA, SHF_INFO_LINK, 8 },
+        { SEC_SYMTAB, symtab.data, symtab.size, SHT_SYMTAB, 0, 8 },
+        { SEC_STRTAB, strtab.data, strtab.size, SHT_STRTAB, 0, 1 },
+        { SEC_NOTE_STACK, NULL, 0, SHT_PROGBITS, 0, 1 },
+        { SEC_SHSTRTAB, shstrtab.data, shstrtab.size, SHT_STRTAB, 0, 1 },
+    };
+    for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+        Elf64_Shdr *s = &sh[parts[i].sec];
+        buf_align(&file, parts[i].align);
+        s->sh_offset = buf_append(&file, parts[i].data, parts[i].size);
+        s->sh_size = parts[i].size;
+        s->sh_type = parts[i].type;
+        s->sh_flags = parts[i].flags;
+        s->sh_addralign = parts[i].align;
+    }
+    sh[SEC_RELA_TEXT].sh_link = SEC_SYMTAB;
+    sh[SEC_RELA_TEXT].sh_info = SEC_TEXT;
+    sh[SEC_RELA_TEXT].sh_entsize = sizeof(Elf64_Rela);
+    sh[SEC_RELA_DATA].sh_link = SEC_SYMTAB;
+    sh[SEC_RELA_DATA].sh_info = SEC_DATA;
+    sh[SEC_RELA_DATA].sh_entsize = sizeof(Elf64_Rela);
+    sh[SEC_SYMTAB].sh_link = SEC_STRTAB;
+    sh[SEC_SYMTAB].sh_info = first_global;
+    sh[SEC_SYMTAB].sh_entsize = sizeof(Elf64_Sym);
+
+    buf_align(&file, 8);
+    size_t shoff = buf_append(&file, sh, sizeof(sh));
+
+    int status = -1;
+    if (!file.failed && !symtab.failed && !strtab.failed && !shstrtab.failed &&
+        !rela_text.failed && !rela_data.failed) {
+        Elf64_Ehdr *eh = (Elf64_Ehdr *)file.data;
+        memcpy(eh->e_ident, ELFMAG, SELFMAG);
+        eh->e_ident[EI_CLASS] = ELFCLASS64;
+        eh->e_ident[EI_DATA] = ELFDATA2LSB;
+        eh->e_ident[EI_VERSION] = EV_CURRENT;
+        eh->e_ident[EI_OSABI] = ELFOSABI_SYSV;
+        eh->e_type = ET_REL;
+        eh->e_machine = EM_X86_64;
+        eh->e_version = EV_CURRENT;
+        eh->e_shoff = shoff;
+        eh->e_ehsize = sizeof(Elf64_Ehdr);
+        eh->e_shentsize = sizeof(Elf64_Shdr);
+        eh->e_shnum = SEC_COUNT;
+        eh->e_shstrndx = SEC_SHSTRTAB;
+
+        FILE *f = fopen(path, "wb");
+        if (f) {
+            size_t written = fwrite(file.data, 1, file.size, f);
+            status = (fclose(f) == 0 && written == file.size) ? 0 : -1;
+        }
+    }
+    free(file.data);
+    free(symtab.data);
+    free(strtab.data);
+    free(shstrtab.data);
+    free(rela_text.data);
+    free(rela_data.data);
+    return status;
+}
+
+int aot_link(const char *obj_path, const char *runtime_lib, const char *exe_path) {
+    const char *cc = getenv("CC");
+    if (!cc || !*cc) cc = "cc";
+
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        execlp(cc, cc, "-o", exe_path, obj_path, runtime_lib, (char *)NULL);
+        perror(cc);
+        _exit(127);
+    }
+    int wstatus;
+    if (waitpid(pid, &wstatus, 0) < 0) return -1;
+    return (WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0) ? 0 : -1;
+}
+
+void aot_default_runtime(char *buf, int len) {
+    const char *env = getenv("VM_RUNTIME");
+    if (env && *env) {
+        snprintf(buf, len, "%s", env);
+        return;
+    }
+    char exe[512];
+    ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (n <= 0) {
+        snprintf(buf, len, "%s", AOT_RUNTIME_LIB);
+        return;
+    }
+    exe[n] = '\0';
+    char *slash = strrchr(exe, '/');
+    if (slash) *slash = '\0';
+    snprintf(buf, len, "%s/%s", exe, AOT_RUNTIME_LIB);
+}
@@ -0,0 +1,23 @@
+#ifndef AOT_H
+#define AOT_H
+
+#include "jit.h"
+
+// Entry symbol of AOT-compiled programs, called by the runtime library's main()
+#define AOT_ENTRY_SYMBOL "vm_program"
+
+// Runtime library (vm.c built with -DAOT_RUNTIME, plus the support modules)
+#define AOT_RUNTIME_LIB "libvmrt.a"
+
+// Write 'obj' as a relocatable x86-64 ELF object. The code is in .text with 'entry' as
+// a global function at offset 0; helper calls are resolved through a .data table
+// relocated against jit_helper_symbols. Returns 0 on success.
+int aot_write_object(const JitObject *obj, const char *entry, const char *path);
+
+// Link an object from aot_write_object() against 'runtime_lib' with $CC (default cc)
+int aot_link(const char *obj_path, const char *runtime_lib, const char *exe_path);
+
+// $VM_RUNTIME, or AOT_RUNTIME_LIB next to the running executable
+void aot_default_runtime(char *buf, int len);
+
+#endif
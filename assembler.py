@@ -7,14 +7,27 @@ OPCODES = {
     "PUSH": 0x01, "POP": 0x02, "DUP": 0x03, "HALT": 0xFF,
     "ADD": 0x10, "SUB": 0x11, "MUL": 0x12, "DIV": 0x13, "CMP": 0x14,
     "JMP": 0x20, "JZ": 0x21, "JNZ": 0x22,
-    "STORE": 0x30, "LOAD": 0x31, "CALL": 0x40, "RET": 0x41,
-    "PRINT": 0x50, "INPUT": 0x51, "ALLOC": 0x60
+    "STORE": 0x30, "LOAD": 0x31, "LOADI": 0x32, "STOREI": 0x33,
+    "LOAD_LOCAL": 0x34, "STORE_LOCAL": 0x35, "CALL": 0x40, "RET": 0x41, "ENTER": 0x42,
+    "PRINT": 0x50, "INPUT": 0x51, "ALLOC": 0x60,
+    "AFILL": 0x70, "ACOPY": 0x71, "ASUM": 0x72, "AMIN": 0x73, "AMAX": 0x74, "AADD": 0x75, "AMUL": 0x76
 }
 
-def assemble(input_file, output_file):
+def symbol_path(output_file):
+    """
+    Symbol file written next to the bytecode: "prog.bin" -> "prog.sym".
+    The VM looks for the same name when it needs label names (e.g. --profile).
+    """
+    if output_file.endswith(".bin"):
+        return output_file[:-4] + ".sym"
+    return output_file + ".sym"
+
+def assemble(input_file, output_file, write_symbols=False):
     """
     Reads an assembly source file and converts it into binary bytecode.
     It uses a two-pass approach to handle labels and forward jumps.
+    If write_symbols is set, the label table is also saved as "<addr> <label>" lines,
+    followed by one "<addr> @<line>" line per instruction giving its source line.
     """
     
     # Read the entire input file into a list of lines
@@ -48,8 +61,11 @@ def assemble(input_file, output_file):
     # --- Pass 2: Generate Bytecode ---
     # Now we scan the code a second time to actually generate the binary data.
     bytecode = bytearray()
+    source_lines = [] # (address, 1-based source line) of every instruction
+    call_targets = {0} # Function entries: the program start and every CALL target
+    enters = []        # (address, source line) of every ENTER
     
-    for line in lines:
+    for line_no, line in enumerate(lines, 1):
         parts = line.split(';')[0].split()
         if not parts: continue
         
@@ -60,6 +76,7 @@ def assemble(input_file, output_file):
         instr = parts[0].upper()
         if instr in OPCODES:
             # 1. Write the Opcode
+            source_lines.append((len(bytecode), line_no))
             bytecode.append(OPCODES[instr])
             
             # 2. Write the Argument (if the instruction has one)
@@ -74,14 +91,33 @@ def assemble(input_file, output_file):
                 
                 # Pack the value as a 32-bit little-endian integer
                 bytecode.extend(struct.pack("<i", val))
+                if instr == "CALL":
+                    call_targets.add(val)
+            if instr == "ENTER":
+                enters.append((source_lines[-1][0], line_no))
+
+    # ENTER sizes the frame of the function it starts, so it may only appear
+    # at a function entry; the VM rejects it anywhere else at run time
+    for enter_addr, line_no in enters:
+        if enter_addr not in call_targets:
+            sys.exit(f"{input_file}:{line_no}: ENTER must be the first instruction of a function")
         
     # Write the final sequence of bytes to the output file
     with open(output_file, 'wb') as f:
         f.write(bytecode)
 
+    # Optionally write the label table, ordered by address (source order for ties),
+    # then the line table
+    if write_symbols:
+        with open(symbol_path(output_file), 'w') as f:
+            for name, label_addr in sorted(labels.items(), key=lambda kv: kv[1]):
+                f.write(f"{label_addr} {name}\n")
+            for insn_addr, line_no in source_lines:
+                f.write(f"{insn_addr} @{line_no}\n")
+
 if __name__ == "__main__":
     # Ensure the user provides input and output filenames
     if len(sys.argv) < 3:
-        print("Usage: python3 assembler.py <input.asm> <output.bin>")
+        print("Usage: python3 assembler.py <input.asm> <output.bin> [--sym]")
     else:
-        assemble(sys.argv[1], sys.argv[2])
\ No newline at end of file
+        assemble(sys.argv[1], sys.argv[2], "--sym" in sys.argv[3:])
\ No newline at end of file
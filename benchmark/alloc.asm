@@ -0,0 +1,22 @@
+; Benchmark: Allocation churn
+; Allocates 500,000 short-lived objects. The counter lives in Memory[0] so the
+; data stack holds no heap-looking values and each collection reclaims everything.
+; Expected Result: 0
+
+PUSH 500000
+STORE 0
+
+LOOP:
+    PUSH 4
+    ALLOC
+    POP             ; Object becomes garbage immediately
+
+    LOAD 0
+    PUSH 1
+    SUB
+    DUP
+    STORE 0
+    JNZ LOOP
+
+LOAD 0
+HALT
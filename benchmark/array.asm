@@ -0,0 +1,57 @@
+; Benchmark: Bulk array kernels (AADD/AMUL/ASUM/AMIN/AMAX)
+; Two 16,384-word arrays are combined element-wise and reduced for 2,000 rounds.
+; Both arrays stay on the data stack; their addresses are also kept in memory.
+; Memory: [0] = a, [1] = b, [2] = rounds left, [3] = checksum
+; Expected Result: 282918912
+
+PUSH 16384
+ALLOC
+DUP
+STORE 0
+PUSH 16384
+ALLOC
+DUP
+STORE 1             ; [a, b]
+
+LOAD 0
+PUSH 1
+AFILL               ; a = [1, 1, ...]
+LOAD 1
+PUSH 3
+AFILL               ; b = [3, 3, ...]
+
+PUSH 2000
+STORE 2
+PUSH 0
+STORE 3
+
+ROUND:
+    LOAD 0
+    LOAD 1
+    AADD            ; a += b
+    LOAD 1
+    LOAD 0
+    AMUL            ; b *= a (wraps)
+    LOAD 0
+    ASUM
+    LOAD 3
+    ADD
+    STORE 3         ; checksum += sum(a)
+    LOAD 1
+    AMAX
+    LOAD 1
+    AMIN
+    SUB
+    LOAD 3
+    ADD
+    STORE 3         ; checksum += max(b) - min(b)
+
+    LOAD 2
+    PUSH 1
+    SUB
+    DUP
+    STORE 2
+    JNZ ROUND
+
+LOAD 3
+HALT
@@ -0,0 +1,533 @@
+// In-process benchmark harness: `make bench`
+//
+// Runs each workload in benchmark/ through every execution mode with warmup and
+// repeated trials, timing only the execution itself (no process start, file I/O
+// or assembly). Results are written as JSON and compared against a stored baseline.
+
+#define TESTING
+#include "../vm.c"
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define MAX_TRIALS 100
+#define DEFAULT_TRIALS 7
+#define DEFAULT_WARMUP 2
+#define DEFAULT_THRESHOLD 0.10
+#define SCHED_TENANTS 8      // Instances per run in the sched modes
+#define SCHED_QUANTUM 1000   // Fuel per slice in the sched modes
+
+typedef struct {
+    const char *name;
+    const char *path;
+    const char *desc;
+} Workload;
+
+static const Workload workloads[] = {
+    { "loop",   "benchmark/loop.bin",   "Tight arithmetic loop (10M iterations)" },
+    { "fib",    "benchmark/fib.bin",    "Recursive fib(24), CALL/RET heavy" },
+    { "calls",  "benchmark/calls.bin",  "Tiny subroutine calls (2M iterations, inlinable)" },
+    { "frames", "benchmark/frames.bin", "Recursive C(20, 10) with frame locals" },
+    { "memory", "benchmark/memory.bin", "Global LOAD/STORE loop (1M iterations)" },
+    { "alloc",  "benchmark/alloc.bin",  "Allocation churn (500k objects)" },
+    { "gc_stress", "benchmark/gc_stress.bin", "Small-object churn (100k 2-word objects)" },
+    { "print",  "benchmark/print.bin",  "Print-heavy output (1M values)" },
+    { "list",   "benchmark/list.bin",   "Linked list build + 100 walks (10k nodes)" },
+    { "tree",   "benchmark/tree.bin",   "Binary tree build + 20 recursive walks (8k nodes)" },
+    { "array",  "benchmark/array.bin",  "Bulk SIMD array ops (2 x 16k words, 2k rounds)" },
+};
+#define NUM_WORKLOADS (int)(sizeof(workloads) / sizeof(workloads[0]))
+
+// sched / sched-jit run SCHED_TENANTS instances round-robin and report the time per
+// instance, so their overhead over interp / jit is the difference in the table
+typedef enum { MODE_INTERP, MODE_JIT, MODE_GC_STRESS, MODE_SCHED, MODE_SCHED_JIT, NUM_MODES } Mode;
+static const char *mode_names[NUM_MODES] = { "interp", "jit", "gc-stress", "sched", "sched-jit" };
+
+// Hardware counters read through perf_event_open (when the kernel allows it)
+typedef enum { CTR_CYCLES, CTR_INSTRUCTIONS, CTR_BRANCH_MISSES, CTR_CACHE_MISSES, NUM_COUNTERS } Counter;
+static const char *counter_names[NUM_COUNTERS] = { "cycles", "instructions", "branch_misses", "cache_misses" };
+static const uint64_t counter_configs[NUM_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES,
+};
+static int counter_fds[NUM_COUNTERS];
+
+typedef enum { STATUS_OK, STATUS_UNSUPPORTED, STATUS_ERROR, STATUS_SKIPPED } Status;
+static const char *status_names[] = { "ok", "unsupported", "error", "n/a" };
+
+typedef struct {
+    const char *workload;
+    const char *mode;
+    Status status;
+    uint64_t vm_instructions;   // Dynamic bytecode instructions per run
+    int trials;
+    double median, min, mean, stddev;
+    int gc_runs;
+    double gc_p99;
+    double max_slice;           // sched modes: longest time slice
+    int has_counter[NUM_COUNTERS];
+    double counters[NUM_COUNTERS]; // Mean per trial
+} Result;
+
+typedef struct {
+    int trials;
+    int warmup;
+    double threshold;
+    const char *out_path;
+    const char *baseline_path;
+    const char *save_baseline_path;
+    const char *filter;
+} Options;
+
+// --- Helpers ---
+// (monotonic_seconds and cmp_double come from vm.c)
+
+static uint8_t *load_file(const char *path, int *out_size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(size > 0 ? size : 1);
+    if (buf && fread(buf, 1, size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *out_size = (int)size;
+    return buf;
+}
+
+static void counters_open(void) {
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = counter_configs[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        counter_fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+static void counters_start(void) {
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        if (counter_fds[i] < 0) continue;
+        ioctl(counter_fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+static void counters_stop(Result *r) {
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        if (counter_fds[i] < 0) continue;
+        ioctl(counter_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t value;
+        if (read(counter_fds[i], &value, sizeof(value)) == sizeof(value)) {
+            r->has_counter[i] = 1;
+            r->counters[i] += (double)value;
+        }
+    }
+}
+
+// Program output (PRINT) goes to /dev/null while a workload runs
+static int silence_stdout(void) {
+    fflush(stdout);
+    io_flush();
+    int saved = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull, STDOUT_FILENO);
+        close(devnull);
+    }
+    return saved;
+}
+
+static void restore_stdout(int saved) {
+    io_flush();
+    if (saved >= 0) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+}
+
+// --- Running ---
+
+static void prepare_vm(VM *vm, uint8_t *code, int size, Mode mode) {
+    memset(vm->memory, 0, sizeof(vm->memory));
+    vm->code = code;
+    vm->code_size = size;
+    vm->gc_stress = (mode == MODE_GC_STRESS);
+    vm->profile = NULL;
+}
+
+// Dynamic instruction count from one profiled run, used to report MIPS.
+// Also reports how many ALLOCs ran, since gc-stress mode is pointless without them.
+static uint64_t count_instructions(VM *vm, uint8_t *code, int size, uint64_t *allocs) {
+    prepare_vm(vm, code, size, MODE_INTERP);
+    vm->profile = profile_create(size);
+    *allocs = 0;
+    if (!vm->profile) return 0;
+    run_vm(vm);
+    uint64_t total = 0;
+    for (int i = 0; i < 256; i++) total += vm->profile->op_counts[i];
+    *allocs = vm->profile->op_counts[ALLOC];
+    profile_free(vm->profile);
+    vm->profile = NULL;
+    return total;
+}
+
+// One sched-mode run: returns 0 and the time per instance if every instance halted
+static int run_sched(uint8_t *code, int size, jit_func fn, double *elapsed, double *max_slice) {
+    Scheduler s;
+    sched_init(&s, SCHED_ROUND_ROBIN, SCHED_QUANTUM);
+    int status = 0;
+    for (int i = 0; status == 0 && i < SCHED_TENANTS; i++) {
+        if (!sched_spawn(&s, code, size, fn, 0)) status = -1;
+    }
+    if (status == 0) {
+        double start = monotonic_seconds();
+        sched_run(&s);
+        *elapsed = (monotonic_seconds() - start) / SCHED_TENANTS;
+        for (int i = 0; i < s.count; i++) {
+            if (s.tasks[i]->status != VM_HALTED) status = -1;
+        }
+        if (s.max_slice > *max_slice) *max_slice = s.max_slice;
+    }
+    sched_free(&s);
+    return status;
+}
+
+static void run_workload(VM *vm, const Workload *w, Mode mode, const Options *opt,
+                         uint8_t *code, int size, uint64_t vm_instructions, Result *r) {
+    memset(r, 0, sizeof(*r));
+    r->workload = w->name;
+    r->mode = mode_names[mode];
+    r->vm_instructions = vm_instructions;
+
+    jit_func jitted = NULL;
+    if (mode == MODE_JIT || mode == MODE_SCHED_JIT) {
+        // The JIT compiles every opcode; a failure here (e.g. code buffer exhausted) is
+        // reported as an unsupported row, so keep its message out of the table
+        fflush(stderr);
+        int saved_err = dup(STDERR_FILENO);
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) { dup2(devnull, STDERR_FILENO); close(devnull); }
+        prepare_vm(vm, code, size, mode);
+        jitted = vm_compile(vm);
+        if (saved_err >= 0) { dup2(saved_err, STDERR_FILENO); close(saved_err); }
+        if (!jitted) {
+            r->status = STATUS_UNSUPPORTED;
+            return;
+        }
+    }
+
+    double times[MAX_TRIALS];
+    int saved = silence_stdout();
+    for (int t = -opt->warmup; t < opt->trials; t++) {
+        double elapsed;
+        if (mode == MODE_SCHED || mode == MODE_SCHED_JIT) {
+            // Instances are created outside the timing; hardware counters are not split per instance
+            double max_slice = 0;
+            if (run_sched(code, size, jitted, &elapsed, &max_slice) != 0) {
+                r->status = STATUS_ERROR;
+                break;
+            }
+            if (t >= 0 && max_slice > r->max_slice) r->max_slice = max_slice;
+        } else if (mode == MODE_JIT) {
+            int result;
+            prepare_vm(vm, code, size, mode);
+            counters_start();
+            double start = monotonic_seconds();
+            int status = vm_run_jit(vm, jitted, &result);
+            elapsed = monotonic_seconds() - start;
+            if (t >= 0) counters_stop(r);
+            if (status != 0) {
+                r->status = STATUS_ERROR;
+                break;
+            }
+        } else {
+            prepare_vm(vm, code, size, mode);
+            counters_start();
+            double start = monotonic_seconds();
+            run_vm(vm);
+            elapsed = monotonic_seconds() - start;
+            if (t >= 0) counters_stop(r);
+            if (vm->error) {
+                r->status = STATUS_ERROR;
+                break;
+            }
+        }
+        if (t >= 0) times[r->trials++] = elapsed;
+    }
+    restore_stdout(saved);
+    if (r->status != STATUS_OK || r->trials == 0) return;
+
+    if (mode != MODE_SCHED && mode != MODE_SCHED_JIT) { // Instances keep their own GC stats
+        GCPauseSummary pauses;
+        vm_gc_pause_summary(vm, &pauses);
+        r->gc_runs = vm->stats_gc_runs;
+        r->gc_p99 = pauses.p99;
+    }
+
+    for (int i = 0; i < NUM_COUNTERS; i++) r->counters[i] /= r->trials;
+
+    double sum = 0;
+    for (int i = 0; i < r->trials; i++) sum += times[i];
+    r->mean = sum / r->trials;
+    double var = 0;
+    for (int i = 0; i < r->trials; i++) var += (times[i] - r->mean) * (times[i] - r->mean);
+    r->stddev = sqrt(var / r->trials);
+
+    qsort(times, r->trials, sizeof(double), cmp_double);
+    r->min = times[0];
+    r->median = (r->trials % 2) ? times[r->trials / 2]
+                                : (times[r->trials / 2 - 1] + times[r->trials / 2]) / 2;
+}
+
+// --- Reporting ---
+
+static void print_result(const Result *r) {
+    if (r->status != STATUS_OK) {
+        printf("%-9s %-10s %s\n", r->workload, r->mode, status_names[r->status]);
+        return;
+    }
+    double mips = r->median > 0 ? (double)r->vm_instructions / r->median / 1e6 : 0;
+    printf("%-9s %-10s %11.3f %11.3f %6.1f%% %10.1f", r->workload, r->mode,
+           r->median * 1e3, r->min * 1e3, r->mean > 0 ? 100.0 * r->stddev / r->mean : 0.0, mips);
+    if (r->gc_runs > 0) printf(" %6d %9.1f", r->gc_runs, r->gc_p99 * 1e6);
+    else printf(" %6s %9s", "-", "-");
+    if (r->has_counter[CTR_CYCLES] && r->has_counter[CTR_INSTRUCTIONS] && r->counters[CTR_CYCLES] > 0) {
+        printf(" %6.2f", r->counters[CTR_INSTRUCTIONS] / r->counters[CTR_CYCLES]);
+    } else {
+        printf(" %6s", "-");
+    }
+    if (r->max_slice > 0) printf("  max slice %.1fus", r->max_slice * 1e6);
+    printf("\n");
+}
+
+// One result object per line, so the baseline can be read back without a JSON parser
+static int write_json(const char *path, const Result *results, int n, const Options *opt) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    fprintf(f, "{\n  \"timestamp\": %ld,\n  \"trials\": %d,\n  \"warmup\": %d,\n  \"results\": [\n",
+            (long)time(NULL), opt->trials, opt->warmup);
+    for (int i = 0; i < n; i++) {
+        const Result *r = &results[i];
+        fprintf(f, "    {\"workload\": \"%s\", \"mode\": \"%s\", \"status\": \"%s\"",
+                r->workload, r->mode, status_names[r->status]);
+        if (r->status == STATUS_OK) {
+            fprintf(f, ", \"median_s\": %.9f, \"min_s\": %.9f, \"mean_s\": %.9f, \"stddev_s\": %.9f, "
+                       "\"trials\": %d, \"vm_instructions\": %llu, \"mips\": %.1f, \"gc_runs\": %d, "
+                       "\"gc_p99_us\": %.3f, ",
+                    r->median, r->min, r->mean, r->stddev, r->trials,
+                    (unsigned long long)r->vm_instructions,
+                    r->median > 0 ? (double)r->vm_instructions / r->median / 1e6 : 0.0,
+                    r->gc_runs, r->gc_p99 * 1e6);
+            if (r->max_slice > 0) fprintf(f, "\"max_slice_us\": %.3f, ", r->max_slice * 1e6);
+            fprintf(f, "\"counters\": {");
+            for (int c = 0; c < NUM_COUNTERS; c++) {
+                fprintf(f, "%s\"%s\": ", c ? ", " : "", counter_names[c]);
+                if (r->has_counter[c]) fprintf(f, "%.0f", r->counters[c]);
+                else fprintf(f, "null");
+            }
+            fprintf(f, "}");
+        }
+        fprintf(f, "}%s\n", i + 1 < n ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+// Extract "key": "value" (string) from a single-line result object
+static int json_string(const char *line, const char *key, char *out, int len) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+    const char *p = strstr(line, pattern);
+    if (!p) return 0;
+    p += strlen(pattern);
+    int i = 0;
+    while (*p && *p != '"' && i < len - 1) out[i++] = *p++;
+    out[i] = '\0';
+    return 1;
+}
+
+static int json_number(const char *line, const char *key, double *out) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char *p = strstr(line, pattern);
+    if (!p) return 0;
+    *out = strtod(p + strlen(pattern), NULL);
+    return 1;
+}
+
+// Returns the number of regressions, or -1 if the baseline can't be read
+static int compare_baseline(const char *path, const Result *results, int n, double threshold) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    printf("\nComparison against %s (threshold %.0f%%)\n", path, threshold * 100);
+    int regressions = 0;
+    char line[2048];
+    while (fgets(line, sizeof(line), f)) {
+        char workload[64], mode[64], status[32];
+        double base;
+        if (!json_string(line, "workload", workload, sizeof(workload)) ||
+            !json_string(line, "mode", mode, sizeof(mode)) ||
+            !json_string(line, "status", status, sizeof(status)) ||
+            strcmp(status, "ok") != 0 || !json_number(line, "median_s", &base) || base <= 0) {
+            continue;
+        }
+
+        for (int i = 0; i < n; i++) {
+            const Result *r = &results[i];
+            if (strcmp(r->workload, workload) != 0 || strcmp(r->mode, mode) != 0) continue;
+            if (r->status != STATUS_OK) {
+                printf("  %-9s %-10s REGRESSION (now %s)\n", workload, mode, status_names[r->status]);
+                regressions++;
+                break;
+            }
+            double change = r->median / base - 1.0;
+            const char *verdict = "ok";
+            if (change > threshold) {
+                verdict = "REGRESSION";
+                regressions++;
+            } else if (change < -threshold) {
+                verdict = "improved";
+            }
+            printf("  %-9s %-10s %11.3f -> %11.3f ms  %+6.1f%%  %s\n", workload, mode,
+                   base * 1e3, r->median * 1e3, change * 100, verdict);
+            break;
+        }
+    }
+    fclose(f);
+    return regressions;
+}
+
+static int parse_options(int argc, char **argv, Options *opt) {
+    opt->trials = DEFAULT_TRIALS;
+    opt->warmup = DEFAULT_WARMUP;
+    opt->threshold = DEFAULT_THRESHOLD;
+    opt->out_path = "benchmark/bench_results.json";
+    opt->baseline_path = NULL;
+    opt->save_baseline_path = NULL;
+    opt->filter = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--trials=", 9) == 0) {
+            opt->trials = atoi(argv[i] + 9);
+        } else if (strncmp(argv[i], "--warmup=", 9) == 0) {
+            opt->warmup = atoi(argv[i] + 9);
+        } else if (strncmp(argv[i], "--threshold=", 12) == 0) {
+            opt->threshold = atof(argv[i] + 12);
+        } else if (strncmp(argv[i], "--out=", 6) == 0) {
+            opt->out_path = argv[i] + 6;
+        } else if (strncmp(argv[i], "--baseline=", 11) == 0) {
+            opt->baseline_path = argv[i] + 11;
+        } else if (strncmp(argv[i], "--save-baseline=", 16) == 0) {
+            opt->save_baseline_path = argv[i] + 16;
+        } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            opt->filter = argv[i] + 9;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return -1;
+        }
+    }
+    if (opt->trials < 1 || opt->trials > MAX_TRIALS || opt->warmup < 0) {
+        fprintf(stderr, "Trials must be 1-%d and warmup >= 0\n", MAX_TRIALS);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    if (parse_options(argc, argv, &opt) != 0) return 2;
+
+    VM *vm = malloc(sizeof(VM));
+    Result *results = calloc(NUM_WORKLOADS * NUM_MODES, sizeof(Result));
+    if (!vm || !results) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 2;
+    }
+    vm_init(vm);
+    counters_open();
+
+    printf("Trials: %d (+%d warmup), hardware counters: %s\n\n", opt.trials, opt.warmup,
+           counter_fds[CTR_CYCLES] >= 0 ? "yes" : "unavailable");
+    printf("%-9s %-10s %11s %11s %7s %10s %6s %9s %6s\n", "Workload", "Mode", "Median(ms)",
+           "Min(ms)", "StdDev", "MIPS", "GCs", "p99(us)", "IPC");
+    printf("%s\n", "------------------------------------------------------------------------------------");
+
+    int n = 0;
+    for (int w = 0; w < NUM_WORKLOADS; w++) {
+        if (opt.filter && !strstr(workloads[w].name, opt.filter)) continue;
+
+        int size;
+        uint8_t *code = load_file(workloads[w].path, &size);
+        if (!code) {
+            fprintf(stderr, "Cannot read %s (run `make bench` to assemble workloads)\n", workloads[w].path);
+            continue;
+        }
+
+        uint64_t allocs;
+        int saved = silence_stdout();
+        uint64_t insns = count_instructions(vm, code, size, &allocs);
+        restore_stdout(saved);
+
+        for (int m = 0; m < NUM_MODES; m++) {
+            if (m == MODE_GC_STRESS && allocs == 0) {
+                memset(&results[n], 0, sizeof(Result));
+                results[n].workload = workloads[w].name;
+                results[n].mode = mode_names[m];
+                results[n].status = STATUS_SKIPPED;
+            } else {
+                run_workload(vm, &workloads[w], (Mode)m, &opt, code, size, insns, &results[n]);
+            }
+            print_result(&results[n]);
+            n++;
+        }
+        free(code);
+        free(vm->gc_records);
+        vm->gc_records = NULL;
+        vm->gc_record_cap = 0;
+    }
+
+    int rc = 0;
+    if (write_json(opt.out_path, results, n, &opt) == 0) {
+        printf("\nResults written to %s\n", opt.out_path);
+    } else {
+        fprintf(stderr, "Error writing %s\n", opt.out_path);
+        rc = 2;
+    }
+
+    if (opt.save_baseline_path) {
+        if (write_json(opt.save_baseline_path, results, n, &opt) == 0) {
+            printf("Baseline saved to %s\n", opt.save_baseline_path);
+        } else {
+            fprintf(stderr, "Error writing %s\n", opt.save_baseline_path);
+            rc = 2;
+        }
+    }
+
+    if (opt.baseline_path) {
+        int regressions = compare_baseline(opt.baseline_path, results, n, opt.threshold);
+        if (regressions < 0) {
+            printf("\nNo baseline at %s (create one with `make bench-baseline`)\n", opt.baseline_path);
+        } else if (regressions > 0) {
+            printf("\n%d regression(s) beyond %.0f%%\n", regressions, opt.threshold * 100);
+            rc = 1;
+        } else {
+            printf("\nNo regressions.\n");
+        }
+    }
+
+    free(results);
+    free(vm);
+    return rc;
+}
@@ -0,0 +1,34 @@
+; Benchmark: Tiny subroutine calls (CALL/RET heavy, inlining candidates)
+; Each of 2M iterations calls STEP, which calls two small leaf helpers.
+; Memory: [0] = iterations left
+; Expected Result: 2000000 * 7 = 14000000
+
+PUSH 0              ; acc
+PUSH 2000000
+STORE 0
+
+LOOP:
+    CALL STEP
+    LOAD 0
+    PUSH 1
+    SUB
+    DUP
+    STORE 0
+    JNZ LOOP
+HALT
+
+; [acc] -> [acc + 7]
+STEP:
+    CALL ADD3
+    CALL ADD4
+    RET
+
+ADD3:
+    PUSH 3
+    ADD
+    RET
+
+ADD4:
+    PUSH 4
+    ADD
+    RET
@@ -0,0 +1,35 @@
+; Benchmark: Recursive Fibonacci (CALL/RET heavy)
+; FIB uses an accumulator contract so it never needs to reach below the top of stack:
+;   [acc, n] -> [acc + fib(n), n]
+; Expected Result: fib(24) = 46368
+
+PUSH 0          ; acc
+PUSH 24         ; n
+CALL FIB
+POP             ; Drop n, leaving acc
+HALT
+
+FIB:
+    DUP
+    JZ FIB_RET      ; fib(0) = 0: nothing to add
+    DUP
+    PUSH 1
+    SUB
+    JZ FIB_ONE      ; n == 1
+    PUSH 1
+    SUB             ; [acc, n-1]
+    CALL FIB        ; [acc + fib(n-1), n-1]
+    PUSH 1
+    SUB             ; [acc', n-2]
+    CALL FIB        ; [acc' + fib(n-2), n-2]
+    PUSH 2
+    ADD             ; [acc + fib(n), n]
+FIB_RET:
+    RET
+
+FIB_ONE:
+    POP
+    PUSH 1
+    ADD             ; acc + 1
+    PUSH 1          ; n
+    RET
@@ -0,0 +1,38 @@
+; Benchmark: Recursive binomial coefficient with frame locals (ENTER / LOAD_LOCAL)
+; Two arguments are kept in locals across both recursive calls, which a
+; stack-only version would have to shuffle with DUP or park in global memory.
+; Expected Result: C(20, 10) = 184756
+
+PUSH 20
+PUSH 10
+CALL BINOM
+HALT
+
+BINOM:
+    ; [n, k] -> [C(n, k)]
+    ENTER 2
+    STORE_LOCAL 1   ; k
+    STORE_LOCAL 0   ; n
+    LOAD_LOCAL 1
+    JZ ONE          ; C(n, 0) = 1
+    LOAD_LOCAL 0
+    LOAD_LOCAL 1
+    SUB
+    JZ ONE          ; C(n, n) = 1
+    LOAD_LOCAL 0
+    PUSH 1
+    SUB
+    LOAD_LOCAL 1
+    PUSH 1
+    SUB
+    CALL BINOM      ; [C(n-1, k-1)]
+    LOAD_LOCAL 0
+    PUSH 1
+    SUB
+    LOAD_LOCAL 1
+    CALL BINOM      ; [C(n-1, k-1), C(n-1, k)]
+    ADD
+    RET
+ONE:
+    PUSH 1
+    RET
@@ -1,19 +1,24 @@
 ; GC Stress Benchmark
 ; Allocates 100,000 objects in a loop to trigger GC
 ; Total objects to allocate: 100,000
+; The counter lives in Memory[0]: a small count on the data stack looks like a heap
+; address to the collector and would keep garbage alive until the heap overflows.
 
 PUSH 100000 ; Loop Counter
+STORE 0
 
 LOOP:
     PUSH 2      ; Size = 2 (Small object)
     ALLOC       ; Allocate
-    POP         ; Discard address (we don't need to keep it alive for this stress test, or we do?)
-                ; If we pop immediately, it becomes garbage.
+    POP         ; Discard address: it becomes garbage immediately.
                 ; This tests "Throughput of Allocation + Collection of Garbage"
     
+    LOAD 0
     PUSH 1
     SUB         ; Decrement Counter
     DUP
+    STORE 0
     JNZ LOOP
 
+LOAD 0
 HALT
@@ -0,0 +1,64 @@
+; Benchmark: Linked list build and traversal (LOADI/STOREI pointer chasing)
+; Builds a 10,000-node list of [value, next] pairs, then walks it 100 times.
+; The head stays on the data stack so the list is reachable in gc-stress mode.
+; Values are negative so the conservative GC never mistakes them for pointers.
+; Memory: [1] = i, [2] = sum, [3] = current node, [4] = passes left
+; Expected Result: -(1 + ... + 10000) * 100 wrapped to int32 = -705532704
+
+PUSH 0              ; head = null
+PUSH 10000
+STORE 1
+
+BUILD:              ; [head]
+    PUSH 2
+    ALLOC
+    STORE 3         ; node (not rooted, but nothing allocates before it is)
+    PUSH 0
+    LOAD 1
+    SUB
+    LOAD 3
+    STOREI          ; node[0] = -i
+    LOAD 3
+    PUSH 1
+    ADD
+    STOREI          ; node[1] = head
+    LOAD 3          ; [node] is the new head
+
+    LOAD 1
+    PUSH 1
+    SUB
+    DUP
+    STORE 1
+    JNZ BUILD
+
+PUSH 100
+STORE 4
+PUSH 0
+STORE 2
+
+WALK:               ; [head]
+    DUP
+    STORE 3
+VISIT:
+    LOAD 3
+    LOADI
+    LOAD 2
+    ADD
+    STORE 2         ; sum += node[0]
+    LOAD 3
+    PUSH 1
+    ADD
+    LOADI
+    DUP
+    STORE 3         ; node = node[1]
+    JNZ VISIT
+
+    LOAD 4
+    PUSH 1
+    SUB
+    DUP
+    STORE 4
+    JNZ WALK
+
+LOAD 2
+HALT
@@ -0,0 +1,26 @@
+; Benchmark: Global Memory LOAD/STORE loop
+; Memory[0] = counter, Memory[1] = running sum, Memory[2] = last value stored
+; Expected Result: sum of 1..1,000,000 modulo 2^32 = 1784293664
+
+PUSH 1000000
+STORE 0
+PUSH 0
+STORE 1
+
+LOOP:
+    LOAD 1
+    LOAD 0
+    ADD
+    DUP
+    STORE 2
+    STORE 1         ; sum += counter
+
+    LOAD 0
+    PUSH 1
+    SUB
+    DUP
+    STORE 0         ; counter -= 1
+    JNZ LOOP
+
+LOAD 1
+HALT
@@ -0,0 +1,15 @@
+; Benchmark: Print-heavy output
+; Prints 1,000,000 numbers (counting down)
+; Expected Result: 0
+
+PUSH 1000000
+
+LOOP:
+    DUP
+    PRINT
+    PUSH 1
+    SUB
+    DUP
+    JNZ LOOP
+
+HALT
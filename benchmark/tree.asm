@@ -0,0 +1,74 @@
+; Benchmark: Binary tree build and recursive walk (CALL/RET + LOADI/STOREI)
+; Builds a complete tree of depth 13 (8,191 nodes of [left, right]), then counts
+; its nodes 20 times. Subtrees under construction stay on the data stack, so the
+; tree is reachable in gc-stress mode.
+; Memory: [9] = depth, [10] = scratch node, [11] = node count, [12] = passes left
+; Expected Result: 8191 * 20 = 163820
+
+PUSH 13
+STORE 9
+CALL BUILD          ; [root]
+
+PUSH 20
+STORE 12
+WALK:
+    DUP
+    CALL COUNT
+    LOAD 12
+    PUSH 1
+    SUB
+    DUP
+    STORE 12
+    JNZ WALK
+
+LOAD 11
+HALT
+
+; [] -> [node] for a tree of depth memory[9] (restored on return)
+BUILD:
+    LOAD 9
+    JZ LEAF
+    LOAD 9
+    PUSH 1
+    SUB
+    STORE 9
+    CALL BUILD      ; [left]
+    CALL BUILD      ; [left, right]
+    LOAD 9
+    PUSH 1
+    ADD
+    STORE 9
+    PUSH 2
+    ALLOC           ; [left, right, node]
+    STORE 10
+    LOAD 10
+    PUSH 1
+    ADD
+    STOREI          ; node[1] = right
+    LOAD 10
+    STOREI          ; node[0] = left
+    LOAD 10
+    RET
+LEAF:
+    PUSH 0          ; null
+    RET
+
+; [node] -> [], adds the number of nodes to memory[11]
+COUNT:
+    DUP
+    JZ NIL
+    LOAD 11
+    PUSH 1
+    ADD
+    STORE 11
+    DUP
+    LOADI
+    CALL COUNT      ; left subtree
+    PUSH 1
+    ADD
+    LOADI
+    CALL COUNT      ; right subtree
+    RET
+NIL:
+    POP
+    RET
@@ -0,0 +1,202 @@
+#include "io.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static int io_mode = IO_MODE_TEXT;
+
+// Output State
+static char out_buf[IO_OUT_BUF_SIZE];
+static size_t out_len = 0;
+
+// Input State: either a view of the mmapped stdin file or of in_buf
+static char in_buf[IO_IN_BUF_SIZE];
+static const char *in_data = NULL;
+static size_t in_len = 0;
+static size_t in_pos = 0;
+static int in_initialized = 0;
+static int in_mapped = 0;
+static int in_eof = 0;
+
+void io_set_mode(int mode) {
+    io_mode = mode;
+}
+
+int io_get_mode(void) {
+    return io_mode;
+}
+
+static void write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return; // Output is lost (e.g. closed pipe); nothing sensible to report
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+}
+
+void io_flush(void) {
+    if (out_len == 0) return;
+    write_all(STDOUT_FILENO, out_buf, out_len);
+    out_len = 0;
+}
+
+// Make room for at least 'needed' bytes, flushing at the size threshold
+static inline void out_reserve(size_t needed) {
+    if (out_len + needed > IO_OUT_BUF_SIZE) io_flush();
+}
+
+static void out_append(const char *s, size_t len) {
+    if (len > IO_OUT_BUF_SIZE) { // Too large to stage, write through
+        io_flush();
+        write_all(STDOUT_FILENO, s, len);
+        return;
+    }
+    out_reserve(len);
+    memcpy(out_buf + out_len, s, len);
+    out_len += len;
+}
+
+void io_write_int(int32_t val) {
+    if (io_mode == IO_MODE_BINARY) {
+        uint32_t u = (uint32_t)val;
+        out_reserve(4);
+        out_buf[out_len++] = (char)(u & 0xFF);
+        out_buf[out_len++] = (char)((u >> 8) & 0xFF);
+        out_buf[out_len++] = (char)((u >> 16) & 0xFF);
+        out_buf[out_len++] = (char)((u >> 24) & 0xFF);
+        return;
+    }
+
+    // Format right-to-left into a scratch buffer: "-2147483648\n" is 12 bytes
+    char tmp[12];
+    char *p = tmp + sizeof(tmp);
+    uint32_t mag = (val < 0) ? 0u - (uint32_t)val : (uint32_t)val;
+    *--p = '\n';
+    do {
+        *--p = (char)('0' + mag % 10);
+        mag /= 10;
+    } while (mag);
+    if (val < 0) *--p = '-';
+
+    size_t len = (size_t)(tmp + sizeof(tmp) - p);
+    out_reserve(len);
+    memcpy(out_buf + out_len, p, len);
+    out_len += len;
+}
+
+void io_prompt(const char *s) {
+    if (io_mode == IO_MODE_BINARY) return;
+    out_append(s, strlen(s));
+}
+
+void io_printf(const char *fmt, ...) {
+    char tmp[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if ((size_t)n >= sizeof(tmp)) n = sizeof(tmp) - 1;
+
+    if (io_mode == IO_MODE_BINARY) {
+        io_flush();
+        write_all(STDERR_FILENO, tmp, (size_t)n);
+    } else {
+        out_append(tmp, (size_t)n);
+    }
+}
+
+// Map stdin if it is a regular file so the whole input is parsed in place
+static void in_init(void) {
+    in_initialized = 1;
+    struct stat st;
+    if (fstat(STDIN_FILENO, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) return;
+
+    off_t offset = lseek(STDIN_FILENO, 0, SEEK_CUR);
+    if (offset < 0 || offset >= st.st_size) return;
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+    if (map == MAP_FAILED) return; // Fall back to read(2)
+
+    in_data = (const char *)map;
+    in_len = (size_t)st.st_size;
+    in_pos = (size_t)offset;
+    in_mapped = 1;
+}
+
+// Read the next chunk of stdin. Returns 0 at end of input.
+static int in_fill(void) {
+    if (!in_initialized) {
+        in_init();
+        if (in_pos < in_len) return 1;
+    }
+    if (in_mapped || in_eof) return 0;
+
+    // Pending output (e.g. a prompt) must be visible before we block
+    io_flush();
+
+    ssize_t n;
+    do {
+        n = read(STDIN_FILENO, in_buf, sizeof(in_buf));
+    } while (n < 0 && errno == EINTR);
+
+    if (n <= 0) {
+        in_eof = 1;
+        return 0;
+    }
+    in_data = in_buf;
+    in_len = (size_t)n;
+    in_pos = 0;
+    return 1;
+}
+
+static inline int in_peek(void) {
+    if (in_pos == in_len && !in_fill()) return -1;
+    return (unsigned char)in_data[in_pos];
+}
+
+int io_read_int(int32_t *out) {
+    if (io_mode == IO_MODE_BINARY) {
+        uint32_t u = 0;
+        for (int i = 0; i < 4; i++) {
+            int c = in_peek();
+            if (c < 0) return 0; // Truncated value
+            u |= (uint32_t)c << (8 * i);
+            in_pos++;
+        }
+        *out = (int32_t)u;
+        return 1;
+    }
+
+    // Same token rules as scanf("%d"): skip whitespace, optional sign, digits
+    int c = in_peek();
+    while (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+        in_pos++;
+        c = in_peek();
+    }
+
+    int negative = 0;
+    if (c == '-' || c == '+') {
+        negative = (c == '-');
+        in_pos++;
+        c = in_peek();
+    }
+    if (c < '0' || c > '9') return 0;
+
+    uint32_t mag = 0;
+    while (c >= '0' && c <= '9') {
+        mag = mag * 10 + (uint32_t)(c - '0');
+        in_pos++;
+        c = in_peek();
+    }
+    *out = (int32_t)(negative ? 0u - mag : mag);
+    return 1;
+}
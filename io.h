@@ -0,0 +1,30 @@
+#ifndef IO_H
+#define IO_H
+
+#include <stdint.h>
+
+// Output is staged in a single buffer and written with one write(2) per flush
+#define IO_OUT_BUF_SIZE (1 << 16)
+// Chunk size for reading stdin when it cannot be mmapped (pipes, terminals)
+#define IO_IN_BUF_SIZE  (1 << 16)
+
+// I/O Modes
+#define IO_MODE_TEXT   0   // Decimal text, one value per line (default)
+#define IO_MODE_BINARY 1   // Raw little-endian int32 stream, prompts suppressed
+
+void io_set_mode(int mode);
+int io_get_mode(void);
+
+// PRINT / INPUT backends
+void io_write_int(int32_t val);
+int io_read_int(int32_t *out);   // Returns 1 on success, 0 on EOF or invalid input
+
+// Human-readable text (prompts, results). Prompts are dropped in binary mode,
+// other text is routed to stderr so it never corrupts the binary stream.
+void io_prompt(const char *s);
+void io_printf(const char *fmt, ...);
+
+// Write all buffered output to stdout
+void io_flush(void);
+
+#endif
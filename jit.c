@@ -7,6 +7,125 @@
 #include <unistd.h>
 
 #define MAX_CODE_SIZE 4096
+#define JIT_NATIVE_SIZE (64 * 1024)  // Helper calls make native code much larger than bytecode
+#define JIT_MAX_INSN_SIZE 128        // Upper bound on native bytes emitted for one instruction
+
+// Calls: every CALL target is compiled once as a native function, except small
+// non-recursive callees, which are inlined so the operand stack flows straight through.
+#define JIT_INLINE_MAX_BYTES 64      // Largest callee (bytecode bytes) that is inlined
+#define AOT_INLINE_MAX_BYTES 256     // Compile time is not on the critical path ahead of time
+#define JIT_INLINE_MAX_DEPTH 4       // Nested inlining limit
+#define JIT_INLINE_BUDGET (JIT_NATIVE_SIZE / 4) // Native bytes of inlined copies per compile
+#define JIT_RSTACK_DEPTH 256         // Return stack entries, as in the interpreter
+#define JIT_OPERAND_DEPTH 256        // Operand stack slots, as in the interpreter
+#define JIT_LOCALS_DEPTH 1024        // Frame-local slots, as in the interpreter
+
+// Native frame, below rbp:
+//   [rbp-40, rbp)                           saved rbx, r12, r13, r14, r15
+//   [rbp-48]                                rsp saved around helper calls
+//   [rbp-LOCALS_BASE, rbp-48)               return stack of native addresses, r13 = next free slot
+//   [rbp-OPERAND_BASE, rbp-LOCALS_BASE)     frame-local slots, growing up; r15 = current frame
+//   below rbp-OPERAND_BASE                  operand stack (push/pop), r14 = lowest allowed rsp
+// r12 holds the runtime context passed to helpers, rbx the fuel left before
+// JIT_HELPER_YIELD.
+//
+// Locals are 64-bit slots addressed as [r15 + 8 * slot]. An out-of-line CALL moves
+// r15 past the caller's frame and back; inlined callees just use the slots after
+// the caller's (the copy's 'frame' offset), so their locals cost no register updates.
+//
+// Fuel: taken backward branches and CALLs decrement rbx; at zero the code calls
+// JIT_HELPER_YIELD, which may suspend it and returns the next budget. Bulk array
+// operations charge rbx through JIT_HELPER_BULK.
+#define FRAME_SAVED 48
+#define SAVED_RSP_DISP ((uint8_t)-48)  // disp8 of the rsp save slot
+#define LOCALS_BASE (FRAME_SAVED + JIT_RSTACK_DEPTH * 8)
+#define OPERAND_BASE (LOCALS_BASE + JIT_LOCALS_DEPTH * 8)
+
+// Runtime helpers (see jit_set_runtime)
+static JitRuntime runtime;
+static int have_runtime = 0;
+
+const char *const jit_helper_symbols[JIT_HELPER_COUNT] = {
+    [JIT_HELPER_ALLOC] = "vm_rt_alloc",
+    [JIT_HELPER_LOAD]  = "vm_rt_load",
+    [JIT_HELPER_STORE] = "vm_rt_store",
+    [JIT_HELPER_BULK]  = "vm_rt_bulk",
+    [JIT_HELPER_TRAP]  = "vm_rt_trap",
+    [JIT_HELPER_PRINT] = "vm_rt_print",
+    [JIT_HELPER_INPUT] = "vm_rt_input",
+    [JIT_HELPER_FUEL]  = "vm_rt_fuel",
+    [JIT_HELPER_YIELD] = "vm_rt_yield",
+};
+
+void jit_set_runtime(const JitRuntime *rt) {
+    runtime = *rt;
+    have_runtime = 1;
+}
+
+// perf integration settings (see jit_set_perf)
+static int perf_flags = 0;
+static const SymTab *perf_syms = NULL;
+static const char *perf_source = NULL;
+
+void jit_set_perf(int flags, const SymTab *syms, const char *source) {
+    perf_flags = flags;
+    perf_syms = syms;
+    perf_source = source;
+}
+
+// Publish one compiled function as one perf symbol per label region, each with its
+// source-line -> native-address line table (from the .sym file). Code before the first label, or
+// without symbols at all, is named after its pc range. 'mapping' holds the native
+// offset of every pc compiled in [native_start, native_end), in increasing order.
+static void publish_perf_regions(uint8_t *mem, const int *mapping, int length,
+                                 int native_start, int native_end) {
+    JitLine *lines = malloc((length > 0 ? length : 1) * sizeof(JitLine));
+    if (!lines) return;
+
+    int end_pc = length;
+    while (end_pc > 0 && mapping[end_pc - 1] == -1) end_pc--;
+    int region_pc = 0;
+    while (region_pc < end_pc && mapping[region_pc] == -1) region_pc++;
+    int first_pc = region_pc;
+
+    while (region_pc < end_pc) {
+        // The region runs until the next compiled label (or the end of compiled code)
+        int next_pc = end_pc;
+        for (int i = 0; perf_syms && i < perf_syms->count; i++) {
+            int32_t addr = perf_syms->syms[i].addr;
+            if (addr > region_pc && addr < end_pc && mapping[addr] != -1) {
+                next_pc = addr;
+                break;
+            }
+        }
+
+        int nlines = 0;
+        for (int pc = region_pc; perf_source && pc < next_pc; pc++) {
+            int32_t line = symtab_source_line(perf_syms, pc);
+            if (mapping[pc] == -1 || line < 0) continue;
+            lines[nlines].addr = (uint64_t)(uintptr_t)(mem + mapping[pc]);
+            lines[nlines].line = line;
+            nlines++;
+        }
+
+        // The first region also owns the prologue
+        int region_start = (region_pc == first_pc) ? native_start : mapping[region_pc];
+        int region_end = (next_pc < end_pc) ? mapping[next_pc] : native_end;
+
+        char name[SYM_NAME_MAX + 16];
+        const Symbol *label = symtab_lookup(perf_syms, region_pc);
+        if (label && label->addr == region_pc) {
+            snprintf(name, sizeof(name), "vm:%s", label->name);
+        } else {
+            snprintf(name, sizeof(name), "vm:pc_%d-%d", region_pc, next_pc);
+        }
+
+        jit_perf_register(perf_flags, name, mem + region_start, (size_t)(region_end - region_start),
+                          lines, nlines, perf_source);
+        region_pc = next_pc;
+    }
+    free(lines);
+}
 
 // Helper to append byte to buffer
 void emit_byte(uint8_t **ptr, uint8_t byte) {
@@ -19,187 +138,840 @@ void emit_int32(uint8_t **ptr, int32_t val) {
     *ptr += 4;
 }
 
-jit_func compile(uint8_t *code, int length) {
-    // 1. Allocate executable memory
-    void *mem = mmap(NULL, MAX_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
-                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (mem == MAP_FAILED) {
-        perror("mmap");
+void emit_int64(uint8_t **ptr, int64_t val) {
+    *(int64_t*)(*ptr) = val;
+    *ptr += 8;
+}
+
+// Restore callee-saved registers and return the top of the stack
+static void emit_epilogue(uint8_t **ptr) {
+    emit_byte(ptr, 0x58); // pop rax (return value)
+    // Reload rbx, r12, r13, r14 from the frame (the operand stack may be at any depth)
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x8B); emit_byte(ptr, 0x5D); emit_byte(ptr, 0xF8); // mov rbx, [rbp-8]
+    emit_byte(ptr, 0x4C); emit_byte(ptr, 0x8B); emit_byte(ptr, 0x65); emit_byte(ptr, 0xF0); // mov r12, [rbp-16]
+    emit_byte(ptr, 0x4C); emit_byte(ptr, 0x8B); emit_byte(ptr, 0x6D); emit_byte(ptr, 0xE8); // mov r13, [rbp-24]
+    emit_byte(ptr, 0x4C); emit_byte(ptr, 0x8B); emit_byte(ptr, 0x75); emit_byte(ptr, 0xE0); // mov r14, [rbp-32]
+    emit_byte(ptr, 0x4C); emit_byte(ptr, 0x8B); emit_byte(ptr, 0x7D); emit_byte(ptr, 0xD8); // mov r15, [rbp-40]
+    emit_byte(ptr, 0xC9); // leave
+    emit_byte(ptr, 0xC3); // ret
+}
+
+// Growable int array (fixup lists, call lists)
+typedef struct {
+    int *v;
+    int n;
+    int cap;
+} IntList;
+
+static int list_push(IntList *l, int x) {
+    if (l->n == l->cap) {
+        int cap = l->cap ? l->cap * 2 : 16;
+        int *v = realloc(l->v, cap * sizeof(int));
+        if (!v) return -1;
+        l->v = v;
+        l->cap = cap;
+    }
+    l->v[l->n++] = x;
+    return 0;
+}
+
+// A function: the instructions reachable from pc 0 or from a CALL target
+typedef struct {
+    int entry;
+    int size;            // Bytecode bytes in the function
+    uint8_t *in_func;    // in_func[pc] is set for every instruction start in the function
+    IntList calls;       // CALL targets
+    int recursive;       // -1 = not yet known
+    int nlocals;         // Frame size set by an ENTER at the entry (0 without one)
+    int *map;            // pc -> native offset of its out-of-line copy (NULL until emitted)
+    int queued;
+    int native_start;
+    int native_end;
+} Func;
+
+typedef struct {
+    const uint8_t *code;
+    int length;
+    uint8_t *mem;
+    uint8_t *ptr;
+    Func **funcs;        // By entry pc
+    IntList queue;       // Entries still to be compiled out of line
+    IntList call_fixups; // (rel32 offset, callee entry) pairs
+    IntList trap_fixups[JIT_TRAP_COUNT]; // rel32 offsets of jumps to each trap stub
+    IntList yield_fixups; // (rel32 offset, resume offset) of each fuel check's jz
+    int inline_max_bytes;
+    int inlined_bytes;   // Native bytes of finished top-level inlined copies
+    int inline_start;    // Native offset of the top-level inlined copy being emitted
+    int aot;             // Address helpers through a table (compile_object) instead of absolutely
+    IntList relocs;      // AOT: (rel32 offset, helper) pairs
+} Jit;
+
+static int native_offset(Jit *jit) {
+    return (int)(jit->ptr - jit->mem);
+}
+
+// Call runtime helper 'id' with ctx in rdi. Remaining arguments must already be in
+// rsi/rdx/rcx. The operand stack has arbitrary depth, so rsp is aligned around the call.
+static int emit_helper_call(Jit *jit, JitHelper id) {
+    uint8_t **ptr = &jit->ptr;
+    emit_byte(ptr, 0x4C); emit_byte(ptr, 0x89); emit_byte(ptr, 0xE7); // mov rdi, r12
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x89); emit_byte(ptr, 0x65); emit_byte(ptr, SAVED_RSP_DISP); // mov [rbp-48], rsp
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x83); emit_byte(ptr, 0xE4); emit_byte(ptr, 0xF0); // and rsp, -16
+    if (jit->aot) {
+        emit_byte(ptr, 0x48); emit_byte(ptr, 0x8B); emit_byte(ptr, 0x05); // mov rax, [rip+rel32]
+        if (list_push(&jit->relocs, native_offset(jit)) != 0 || list_push(&jit->relocs, id) != 0) return -1;
+        emit_int32(ptr, 0);
+    } else {
+        emit_byte(ptr, 0x48); emit_byte(ptr, 0xB8); // mov rax, imm64
+        emit_int64(ptr, (int64_t)(uintptr_t)runtime.helpers[id]);
+    }
+    emit_byte(ptr, 0xFF); emit_byte(ptr, 0xD0); // call rax
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x8B); emit_byte(ptr, 0x65); emit_byte(ptr, SAVED_RSP_DISP); // mov rsp, [rbp-48]
+    return 0;
+}
+
+// Push the int32 returned by the last helper call
+static void emit_push_result(uint8_t **ptr) {
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x63); emit_byte(ptr, 0xC0); // movsxd rax, eax
+    emit_byte(ptr, 0x50); // push rax
+}
+
+static int insn_length(uint8_t opcode) {
+    switch (opcode) {
+        case PUSH: case JMP: case JZ: case JNZ: case STORE: case LOAD: case CALL:
+        case LOAD_LOCAL: case STORE_LOCAL: case ENTER: return 5;
+        default: return 1;
+    }
+}
+
+static void patch_rel32(Jit *jit, int patch, int target) {
+    *(int32_t *)(jit->mem + patch) = target - (patch + 4);
+}
+
+static void free_func(Func *f) {
+    if (!f) return;
+    free(f->in_func);
+    free(f->calls.v);
+    free(f->map);
+    free(f);
+}
+
+// Discover the function entered at 'entry' (memoized). Returns NULL on malformed code.
+static Func *func_at(Jit *jit, int entry) {
+    if (jit->funcs[entry]) return jit->funcs[entry];
+
+    Func *f = calloc(1, sizeof(Func));
+    int *work = malloc((2 * jit->length + 1) * sizeof(int));
+    if (f) f->in_func = calloc(jit->length, 1);
+    if (!f || !work || !f->in_func) {
+        fprintf(stderr, "JIT Error: Out of memory\n");
+        free(work);
+        free_func(f);
         return NULL;
     }
+    f->entry = entry;
+    f->recursive = -1;
 
-    uint8_t *ptr = (uint8_t *)mem;
-    int pc = 0;
+    int n = 0;
+    work[n++] = entry;
+    while (n > 0) {
+        int pc = work[--n];
+        if (f->in_func[pc]) continue;
+        uint8_t opcode = jit->code[pc];
+        int len = insn_length(opcode);
+        if (pc + len > jit->length) {
+            fprintf(stderr, "JIT Error: Truncated instruction at %d\n", pc);
+            goto fail;
+        }
+        f->in_func[pc] = 1;
+        f->size += len;
 
-    // 2. Prologue: Setup stack frame
-    // push rbp
-    emit_byte(&ptr, 0x55);
-    // mov rbp, rsp
-    emit_byte(&ptr, 0x48);
-    emit_byte(&ptr, 0x89);
-    emit_byte(&ptr, 0xE5);
-    // push rbx (callee-saved)
-    emit_byte(&ptr, 0x53);
-
-    // Map from bytecode offset to machine code offset
-    int mapping[MAX_CODE_SIZE];
-    for (int i = 0; i < MAX_CODE_SIZE; i++) mapping[i] = -1;
-
-    while (pc < length) {
-        int current_pc = pc;
-        mapping[pc] = (int)((uint8_t*)ptr - (uint8_t*)mem);
-        
-        uint8_t opcode = code[pc++];
-
-        switch (opcode) {
-            case PUSH: {
-                int32_t val = *(int32_t *)&code[pc];
-                pc += 4;
-                emit_byte(&ptr, 0x68);
-                emit_int32(&ptr, val);
-                break;
-            }
-            case POP: {
-                emit_byte(&ptr, 0x58);
-                break;
-            }
-            case DUP: { // Added DUP for loop benchmark
-                // pop rax
-                emit_byte(&ptr, 0x58);
-                // push rax
-                emit_byte(&ptr, 0x50);
-                // push rax
-                emit_byte(&ptr, 0x50);
-                break;
-            }
-            case ADD: {
-                emit_byte(&ptr, 0x5B);
-                emit_byte(&ptr, 0x58);
-                emit_byte(&ptr, 0x48); emit_byte(&ptr, 0x01); emit_byte(&ptr, 0xD8);
-                emit_byte(&ptr, 0x50);
-                break;
-            }
-            case SUB: {
-                emit_byte(&ptr, 0x5B);
-                emit_byte(&ptr, 0x58);
-                emit_byte(&ptr, 0x48); emit_byte(&ptr, 0x29); emit_byte(&ptr, 0xD8);
-                emit_byte(&ptr, 0x50);
-                break;
-            }
-            case MUL: {
-                emit_byte(&ptr, 0x5B);
-                emit_byte(&ptr, 0x58);
-                emit_byte(&ptr, 0x48); emit_byte(&ptr, 0x0F); emit_byte(&ptr, 0xAF); emit_byte(&ptr, 0xC3);
-                emit_byte(&ptr, 0x50);
-                break;
+        if (len == 5 && (opcode == JMP || opcode == JZ || opcode == JNZ || opcode == CALL)) {
+            int32_t target = *(int32_t *)&jit->code[pc + 1];
+            if (target < 0 || target >= jit->length) {
+                fprintf(stderr, "JIT Error: Branch target %d out of range\n", target);
+                goto fail;
             }
-            case CMP: {
-               // pop rbx (second)
-                emit_byte(&ptr, 0x5B);
-                // pop rax (first)
-                emit_byte(&ptr, 0x58);
-                
-                // cmp rax, rbx
-                emit_byte(&ptr, 0x48);
-                emit_byte(&ptr, 0x39);
-                emit_byte(&ptr, 0xD8);
-                
-                // setl al (set if less) - VM CMP is: (a < b) ? 1 : 0
-                emit_byte(&ptr, 0x0F); 
-                emit_byte(&ptr, 0x9C); 
-                emit_byte(&ptr, 0xC0); // setl al
-                
-                // movzx rax, al (zero extend to 64-bit)
-                emit_byte(&ptr, 0x48);
-                emit_byte(&ptr, 0x0F);
-                emit_byte(&ptr, 0xB6);
-                emit_byte(&ptr, 0xC0);
-                
-                // push rax
-                emit_byte(&ptr, 0x50);
-                break;
+            if (opcode == CALL) {
+                if (list_push(&f->calls, target) != 0) goto fail;
+            } else {
+                work[n++] = target;
             }
-            // Control Flow
-            case JMP: {
-                int32_t target = *(int32_t *)&code[pc];
-                pc += 4;
-                // For simplified JIT, assuming backward jump to existing code (e.g. for loop)
-                if (target < current_pc && mapping[target] != -1) {
-                    // jmp rel32 (E9 rel32)
-                    int current_offset = (int)((uint8_t*)ptr - (uint8_t*)mem);
-                    int target_offset = mapping[target];
-                    int rel32 = target_offset - (current_offset + 5);
-                    emit_byte(&ptr, 0xE9);
-                    emit_int32(&ptr, rel32);
-                } else {
-                    fprintf(stderr, "JIT Error: Forward/Unknown JMP not implemented yet\n");
-                    return NULL;
-                }
-                break;
+        }
+        // Falling off the end of the code is compiled as an implicit HALT
+        if (opcode != JMP && opcode != RET && opcode != HALT && pc + len < jit->length) {
+            work[n++] = pc + len;
+        }
+    }
+    free(work);
+    if (jit->code[entry] == ENTER) f->nlocals = *(int32_t *)&jit->code[entry + 1];
+    jit->funcs[entry] = f;
+    return f;
+
+fail:
+    free(work);
+    free_func(f);
+    return NULL;
+}
+
+// Does the call graph lead from 'from' back to 'target'?
+static int calls_reach(Jit *jit, int from, int target, uint8_t *seen) {
+    Func *f = func_at(jit, from);
+    if (!f) return 1; // Malformed: never inline it
+    for (int i = 0; i < f->calls.n; i++) {
+        int callee = f->calls.v[i];
+        if (callee == target) return 1;
+        if (seen[callee]) continue;
+        seen[callee] = 1;
+        if (calls_reach(jit, callee, target, seen)) return 1;
+    }
+    return 0;
+}
+
+// Nested copies multiply: fan-out n at every level emits n^depth copies of the leaf.
+// Once JIT_INLINE_BUDGET is spent, calls stay out of line; the copies in progress
+// finish past it by at most one callee body per level.
+static int should_inline(Jit *jit, Func *f, int depth) {
+    if (f->size > jit->inline_max_bytes || depth >= JIT_INLINE_MAX_DEPTH) return 0;
+    int used = jit->inlined_bytes + (depth > 0 ? native_offset(jit) - jit->inline_start : 0);
+    if (used >= JIT_INLINE_BUDGET) return 0;
+    if (f->recursive < 0) {
+        uint8_t *seen = calloc(jit->length, 1);
+        f->recursive = !seen || calls_reach(jit, f->entry, f->entry, seen);
+        free(seen);
+    }
+    return !f->recursive;
+}
+
+// Conditional jump (2-byte opcode) to the stub that reports 'trap'
+static int emit_trap_jump(Jit *jit, uint8_t cc, JitTrap trap) {
+    emit_byte(&jit->ptr, 0x0F); emit_byte(&jit->ptr, cc);
+    if (list_push(&jit->trap_fixups[trap], native_offset(jit)) != 0) return -1;
+    emit_int32(&jit->ptr, 0);
+    return 0;
+}
+
+// Report 'trap' unconditionally (errors the compiler can already see)
+static int emit_trap_call(Jit *jit, JitTrap trap) {
+    emit_byte(&jit->ptr, 0xBE); emit_int32(&jit->ptr, trap); // mov esi, trap
+    return emit_helper_call(jit, JIT_HELPER_TRAP);
+}
+
+// Take the budget returned by JIT_HELPER_FUEL / JIT_HELPER_YIELD
+static void emit_store_fuel(uint8_t **ptr) {
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x63); emit_byte(ptr, 0xD8); // movsxd rbx, eax
+}
+
+// Charge one unit of fuel. Every taken back-edge and call pays for this, inlined copies
+// included, so only the decrement and a never-taken jz stay in line; the slow path
+// is emitted after the code (see emit_program).
+static int emit_fuel_check(Jit *jit) {
+    uint8_t **ptr = &jit->ptr;
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0xFF); emit_byte(ptr, 0xCB); // dec rbx
+    emit_byte(ptr, 0x0F); emit_byte(ptr, 0x84); // jz rel32 (patched once the slow path is placed)
+    if (list_push(&jit->yield_fixups, native_offset(jit)) != 0 ||
+        list_push(&jit->yield_fixups, native_offset(jit) + 4) != 0) return -1;
+    emit_int32(ptr, 0);
+    return 0;
+}
+
+// Trap if the operand stack has grown past JIT_OPERAND_DEPTH slots
+static int emit_stack_check(Jit *jit) {
+    // cmp rsp, r14
+    emit_byte(&jit->ptr, 0x4C); emit_byte(&jit->ptr, 0x39); emit_byte(&jit->ptr, 0xF4);
+    return emit_trap_jump(jit, 0x82, JIT_TRAP_STACK_OVERFLOW); // jb
+}
+
+// Jump (E9) or conditional jump (0F cc) to bytecode 'target' of the current copy.
+// 'map' gives targets already emitted; forward targets are queued in 'fixups'.
+static int emit_jump(Jit *jit, uint8_t cc, int target, const int *map, IntList *fixups) {
+    if (cc) {
+        emit_byte(&jit->ptr, 0x0F); emit_byte(&jit->ptr, cc);
+    } else {
+        emit_byte(&jit->ptr, 0xE9);
+    }
+    int patch = native_offset(jit);
+    emit_int32(&jit->ptr, 0);
+    if (target >= 0 && map[target] != -1) {
+        patch_rel32(jit, patch, map[target]);
+        return 0;
+    }
+    if (list_push(fixups, patch) != 0 || list_push(fixups, target) != 0) return -1;
+    return 0;
+}
+
+static int emit_copy(Jit *jit, Func *f, int depth, int frame);
+
+// Out-of-line CALL: push the native return address on the return stack and jump.
+// 'frame_end' is the first local slot (relative to r15) past the caller's frame.
+static int emit_call(Jit *jit, Func *callee, int frame_end) {
+    uint8_t **ptr = &jit->ptr;
+    if (emit_fuel_check(jit) != 0) return -1;
+    // Return stack full?  lea rax, [rbp-48]; cmp r13, rax; jae
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x8D); emit_byte(ptr, 0x45); emit_byte(ptr, (uint8_t)-FRAME_SAVED);
+    emit_byte(ptr, 0x49); emit_byte(ptr, 0x39); emit_byte(ptr, 0xC5);
+    if (emit_trap_jump(jit, 0x83, JIT_TRAP_RETURN_OVERFLOW) != 0) return -1;
+    if (emit_stack_check(jit) != 0) return -1;
+
+    if (frame_end) { // add r15, frame_end * 8
+        emit_byte(ptr, 0x49); emit_byte(ptr, 0x81); emit_byte(ptr, 0xC7); emit_int32(ptr, frame_end * 8);
+    }
+    // lea rax, [rip+13] (the instruction after the jmp below)
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x8D); emit_byte(ptr, 0x05); emit_int32(ptr, 13);
+    emit_byte(ptr, 0x49); emit_byte(ptr, 0x89); emit_byte(ptr, 0x45); emit_byte(ptr, 0x00); // mov [r13], rax
+    emit_byte(ptr, 0x49); emit_byte(ptr, 0x83); emit_byte(ptr, 0xC5); emit_byte(ptr, 0x08); // add r13, 8
+    emit_byte(ptr, 0xE9); // jmp rel32 (patched once the callee is placed)
+    if (list_push(&jit->call_fixups, native_offset(jit)) != 0 ||
+        list_push(&jit->call_fixups, callee->entry) != 0) return -1;
+    emit_int32(ptr, 0);
+    if (frame_end) { // Returned: sub r15, frame_end * 8
+        emit_byte(ptr, 0x49); emit_byte(ptr, 0x81); emit_byte(ptr, 0xEF); emit_int32(ptr, frame_end * 8);
+    }
+
+    if (!callee->queued) {
+        callee->queued = 1;
+        if (list_push(&jit->queue, callee->entry) != 0) return -1;
+    }
+    return 0;
+}
+
+// Emit one instruction of a copy at 'depth' (0 = out of line) whose locals start at
+// slot 'frame' relative to r15. Returns -1 on error.
+static int emit_insn(Jit *jit, Func *f, int depth, int frame, int pc, int is_last,
+                     const int *map, IntList *fixups) {
+    uint8_t **ptr = &jit->ptr;
+    const uint8_t *code = jit->code;
+    uint8_t opcode = code[pc];
+    int32_t imm = (insn_length(opcode) == 5) ? *(int32_t *)&code[pc + 1] : 0;
+
+    switch (opcode) {
+        case PUSH: {
+            emit_byte(ptr, 0x68);
+            emit_int32(ptr, imm);
+            break;
+        }
+        case POP: {
+            emit_byte(ptr, 0x58);
+            break;
+        }
+        case DUP: { // Added DUP for loop benchmark
+            // pop rax
+            emit_byte(ptr, 0x58);
+            // push rax
+            emit_byte(ptr, 0x50);
+            // push rax
+            emit_byte(ptr, 0x50);
+            break;
+        }
+        case ADD: {
+            emit_byte(ptr, 0x59);
+            emit_byte(ptr, 0x58);
+            emit_byte(ptr, 0x48); emit_byte(ptr, 0x01); emit_byte(ptr, 0xC8);
+            emit_byte(ptr, 0x50);
+            break;
+        }
+        case SUB: {
+            emit_byte(ptr, 0x59);
+            emit_byte(ptr, 0x58);
+            emit_byte(ptr, 0x48); emit_byte(ptr, 0x29); emit_byte(ptr, 0xC8);
+            emit_byte(ptr, 0x50);
+            break;
+        }
+        case MUL: {
+            emit_byte(ptr, 0x59);
+            emit_byte(ptr, 0x58);
+            emit_byte(ptr, 0x48); emit_byte(ptr, 0x0F); emit_byte(ptr, 0xAF); emit_byte(ptr, 0xC1);
+            emit_byte(ptr, 0x50);
+            break;
+        }
+        case DIV: {
+            // 32-bit signed division, as in the interpreter
+            emit_byte(ptr, 0x59); // pop rcx (divisor)
+            emit_byte(ptr, 0x58); // pop rax (dividend)
+            emit_byte(ptr, 0x85); emit_byte(ptr, 0xC9); // test ecx, ecx
+            if (emit_trap_jump(jit, 0x84, JIT_TRAP_DIVISION_BY_ZERO) != 0) return -1; // je
+            // idiv faults on INT32_MIN / -1, so negate (wrapping) instead
+            emit_byte(ptr, 0x83); emit_byte(ptr, 0xF9); emit_byte(ptr, 0xFF); // cmp ecx, -1
+            emit_byte(ptr, 0x75); emit_byte(ptr, 0x04); // jne +4
+            emit_byte(ptr, 0xF7); emit_byte(ptr, 0xD8); // neg eax
+            emit_byte(ptr, 0xEB); emit_byte(ptr, 0x03); // jmp +3
+            emit_byte(ptr, 0x99);                       // cdq
+            emit_byte(ptr, 0xF7); emit_byte(ptr, 0xF9); // idiv ecx
+            emit_push_result(ptr);
+            break;
+        }
+        case CMP: {
+            // pop rcx (second)
+            emit_byte(ptr, 0x59);
+            // pop rax (first)
+            emit_byte(ptr, 0x58);
+
+            // cmp rax, rcx
+            emit_byte(ptr, 0x48);
+            emit_byte(ptr, 0x39);
+            emit_byte(ptr, 0xC8);
+
+            // setl al (set if less) - VM CMP is: (a < b) ? 1 : 0
+            emit_byte(ptr, 0x0F);
+            emit_byte(ptr, 0x9C);
+            emit_byte(ptr, 0xC0); // setl al
+
+            // movzx rax, al (zero extend to 64-bit)
+            emit_byte(ptr, 0x48);
+            emit_byte(ptr, 0x0F);
+            emit_byte(ptr, 0xB6);
+            emit_byte(ptr, 0xC0);
+
+            // push rax
+            emit_byte(ptr, 0x50);
+            break;
+        }
+        // Control Flow: backward branches (loops) also check the operand stack depth and,
+        // like the interpreter, charge fuel only when taken
+        case JMP: {
+            if (imm <= pc && (emit_stack_check(jit) != 0 || emit_fuel_check(jit) != 0)) return -1;
+            // jmp rel32 (E9 rel32)
+            return emit_jump(jit, 0, imm, map, fixups);
+        }
+        case JZ:
+        case JNZ: {
+            if (imm <= pc && emit_stack_check(jit) != 0) return -1;
+            // pop rax
+            emit_byte(ptr, 0x58);
+            // test rax, rax (48 85 C0)
+            emit_byte(ptr, 0x48); emit_byte(ptr, 0x85); emit_byte(ptr, 0xC0);
+            // je / jne rel32 (0F 84 / 0F 85 rel32)
+            if (imm > pc) return emit_jump(jit, (opcode == JZ) ? 0x84 : 0x85, imm, map, fixups);
+            // Backward: jne / je rel8 over the fuel check and a jmp to the target
+            emit_byte(ptr, (opcode == JZ) ? 0x75 : 0x74);
+            emit_byte(ptr, 0);
+            int skip = native_offset(jit);
+            if (emit_fuel_check(jit) != 0 || emit_jump(jit, 0, imm, map, fixups) != 0) return -1;
+            jit->mem[skip - 1] = (uint8_t)(native_offset(jit) - skip);
+            return 0;
+        }
+        case CALL: {
+            if (imm == 0) { // pc 0 is compiled as the entry function, which cannot return
+                fprintf(stderr, "JIT Error: CALL to pc 0 not supported\n");
+                return -1;
             }
-            case JZ: {
-                int32_t target = *(int32_t *)&code[pc];
-                pc += 4;
-                // pop rax
-                emit_byte(&ptr, 0x58);
-                // test rax, rax (48 85 C0)
-                emit_byte(&ptr, 0x48); emit_byte(&ptr, 0x85); emit_byte(&ptr, 0xC0);
-                
-                if (target < current_pc && mapping[target] != -1) {
-                    // je rel32 (0F 84 rel32)
-                    int current_offset = (int)((uint8_t*)ptr - (uint8_t*)mem);
-                    int target_offset = mapping[target];
-                    int rel32 = target_offset - (current_offset + 6); // 2 bytes opcode + 4 bytes rel
-                    emit_byte(&ptr, 0x0F);
-                    emit_byte(&ptr, 0x84);
-                    emit_int32(&ptr, rel32);
-                } else {
-                    fprintf(stderr, "JIT Error: Forward/Unknown JZ not implemented\n");
-                    return NULL;
-                }
-                break;
+            Func *callee = func_at(jit, imm);
+            if (!callee) return -1;
+            if (should_inline(jit, callee, depth)) {
+                // Inlined calls pay the same unit of fuel as out-of-line ones
+                if (emit_fuel_check(jit) != 0) return -1;
+                if (depth > 0) return emit_copy(jit, callee, depth + 1, frame + f->nlocals);
+                jit->inline_start = native_offset(jit);
+                if (emit_copy(jit, callee, depth + 1, frame + f->nlocals) != 0) return -1;
+                jit->inlined_bytes += native_offset(jit) - jit->inline_start;
+                return 0;
             }
-            case JNZ: {
-                int32_t target = *(int32_t *)&code[pc];
-                pc += 4;
-                // pop rax
-                emit_byte(&ptr, 0x58);
-                // test rax, rax
-                emit_byte(&ptr, 0x48); emit_byte(&ptr, 0x85); emit_byte(&ptr, 0xC0);
-                
-                if (target < current_pc && mapping[target] != -1) {
-                    // jne rel32 (0F 85 rel32)
-                    int current_offset = (int)((uint8_t*)ptr - (uint8_t*)mem);
-                    int target_offset = mapping[target];
-                    int rel32 = target_offset - (current_offset + 6);
-                    emit_byte(&ptr, 0x0F);
-                    emit_byte(&ptr, 0x85);
-                    emit_int32(&ptr, rel32);
-                } else {
-                    fprintf(stderr, "JIT Error: Forward/Unknown JNZ not implemented\n");
-                    return NULL;
-                }
-                break;
+            return emit_call(jit, callee, frame + f->nlocals);
+        }
+        case RET: {
+            if (depth > 0) {
+                // Inlined: continue after the copy
+                if (!is_last) return emit_jump(jit, 0, -1, map, fixups);
+            } else if (f->entry == 0) {
+                // pc 0 is never CALLed, so this RET has nothing to return to
+                if (emit_trap_call(jit, JIT_TRAP_RETURN_UNDERFLOW) != 0) return -1;
+            } else {
+                emit_byte(ptr, 0x49); emit_byte(ptr, 0x83); emit_byte(ptr, 0xED); emit_byte(ptr, 0x08); // sub r13, 8
+                emit_byte(ptr, 0x41); emit_byte(ptr, 0xFF); emit_byte(ptr, 0x65); emit_byte(ptr, 0x00); // jmp [r13]
             }
+            break;
+        }
+        case ENTER: {
+            // The frame size is fixed per function, so ENTER belongs at its entry only;
+            // elsewhere it is a runtime error, as in the interpreter
+            if (pc != f->entry) return emit_trap_call(jit, JIT_TRAP_MISPLACED_ENTER);
+            if (imm < 0 || imm > JIT_LOCALS_DEPTH) return emit_trap_call(jit, JIT_TRAP_FRAME_OVERFLOW);
+            int32_t end = (frame + imm) * 8;
+            // Frame full?  lea rax, [r15+end]; lea rcx, [rbp-LOCALS_BASE]; cmp rax, rcx; ja
+            emit_byte(ptr, 0x49); emit_byte(ptr, 0x8D); emit_byte(ptr, 0x87); emit_int32(ptr, end);
+            emit_byte(ptr, 0x48); emit_byte(ptr, 0x8D); emit_byte(ptr, 0x8D); emit_int32(ptr, -LOCALS_BASE);
+            emit_byte(ptr, 0x48); emit_byte(ptr, 0x39); emit_byte(ptr, 0xC8);
+            if (emit_trap_jump(jit, 0x87, JIT_TRAP_FRAME_OVERFLOW) != 0) return -1;
+            // Zero the slots: lea rdi, [r15+frame*8]; mov ecx, n; xor eax, eax; rep stosq
+            emit_byte(ptr, 0x49); emit_byte(ptr, 0x8D); emit_byte(ptr, 0xBF); emit_int32(ptr, frame * 8);
+            emit_byte(ptr, 0xB9); emit_int32(ptr, imm);
+            emit_byte(ptr, 0x31); emit_byte(ptr, 0xC0);
+            emit_byte(ptr, 0xF3); emit_byte(ptr, 0x48); emit_byte(ptr, 0xAB);
+            break;
+        }
+
+        // Locals live in native stack slots (ENTER sized the frame)
+        case LOAD_LOCAL: {
+            if (imm < 0 || imm >= f->nlocals) return emit_trap_call(jit, JIT_TRAP_INVALID_LOCAL);
+            // push qword [r15 + slot*8]
+            emit_byte(ptr, 0x41); emit_byte(ptr, 0xFF); emit_byte(ptr, 0xB7); emit_int32(ptr, (frame + imm) * 8);
+            break;
+        }
+        case STORE_LOCAL: {
+            if (imm < 0 || imm >= f->nlocals) return emit_trap_call(jit, JIT_TRAP_INVALID_LOCAL);
+            // pop qword [r15 + slot*8]
+            emit_byte(ptr, 0x41); emit_byte(ptr, 0x8F); emit_byte(ptr, 0x87); emit_int32(ptr, (frame + imm) * 8);
+            break;
+        }
+
+        // Memory: bounds checks and heap addressing live in the runtime
+        case LOAD: {
+            emit_byte(ptr, 0xBE); emit_int32(ptr, imm); // mov esi, imm32
+            if (emit_helper_call(jit, JIT_HELPER_LOAD) != 0) return -1;
+            emit_push_result(ptr);
+            break;
+        }
+        case STORE: {
+            emit_byte(ptr, 0xBE); emit_int32(ptr, imm); // mov esi, imm32
+            emit_byte(ptr, 0x5A); // pop rdx (value)
+            return emit_helper_call(jit, JIT_HELPER_STORE);
+        }
+        case LOADI: {
+            emit_byte(ptr, 0x5E); // pop rsi (address)
+            if (emit_helper_call(jit, JIT_HELPER_LOAD) != 0) return -1;
+            emit_push_result(ptr);
+            break;
+        }
+        case STOREI: {
+            emit_byte(ptr, 0x5E); // pop rsi (address)
+            emit_byte(ptr, 0x5A); // pop rdx (value)
+            return emit_helper_call(jit, JIT_HELPER_STORE);
+        }
+        case ALLOC: {
+            emit_byte(ptr, 0x5E); // pop rsi (size)
+            // mov rdx, rsp; lea rcx, [rbp-LOCALS_BASE] (operand stack and locals for the GC)
+            emit_byte(ptr, 0x48); emit_byte(ptr, 0x89); emit_byte(ptr, 0xE2);
+            emit_byte(ptr, 0x48); emit_byte(ptr, 0x8D); emit_byte(ptr, 0x8D); emit_int32(ptr, -LOCALS_BASE);
+            if (emit_helper_call(jit, JIT_HELPER_ALLOC) != 0) return -1;
+            emit_push_result(ptr);
+            break;
+        }
+        // Bulk array operations run the runtime's SIMD kernels, which charge fuel by
+        // length: rbx is spilled to the operand stack and passed by address in r8
+        case AFILL:
+        case ACOPY:
+        case AADD:
+        case AMUL:
+        case ASUM:
+        case AMIN:
+        case AMAX: {
+            int binary = opcode == AFILL || opcode == ACOPY || opcode == AADD || opcode == AMUL;
+            if (binary) emit_byte(ptr, 0x59); // pop rcx (value / source)
+            emit_byte(ptr, 0x5A); // pop rdx (object)
+            emit_byte(ptr, 0x53); // push rbx
+            emit_byte(ptr, 0x49); emit_byte(ptr, 0x89); emit_byte(ptr, 0xE0); // mov r8, rsp
+            emit_byte(ptr, 0xBE); emit_int32(ptr, opcode); // mov esi, op
+            if (emit_helper_call(jit, JIT_HELPER_BULK) != 0) return -1;
+            emit_byte(ptr, 0x5B); // pop rbx
+            if (!binary) emit_push_result(ptr);
+            break;
+        }
+
+        // Standard library
+        case PRINT: {
+            emit_byte(ptr, 0x5E); // pop rsi (value)
+            return emit_helper_call(jit, JIT_HELPER_PRINT);
+        }
+        case INPUT: {
+            if (emit_stack_check(jit) != 0) return -1;
+            if (emit_helper_call(jit, JIT_HELPER_INPUT) != 0) return -1;
+            emit_push_result(ptr);
+            break;
+        }
+
+        case HALT: {
+            emit_epilogue(ptr);
+            break;
+        }
+        default:
+            fprintf(stderr, "JIT Error: Unsupported opcode 0x%02X\n", opcode);
+            return -1;
+    }
+    return 0;
+}
+
+// Emit a copy of function 'f': out of line at depth 0, otherwise inlined at the
+// current position. Instructions are laid out in bytecode order.
+static int emit_copy(Jit *jit, Func *f, int depth, int frame) {
+    int length = jit->length;
+    int *map = malloc(length * sizeof(int));
+    IntList fixups = { 0 }; // (rel32 offset, target pc) pairs; pc -1 = end of the copy
+    if (!map) {
+        fprintf(stderr, "JIT Error: Out of memory\n");
+        return -1;
+    }
+    for (int i = 0; i < length; i++) map[i] = -1;
+
+    int first = 0;
+    while (!f->in_func[first]) first++;
+    int status = 0;
+    if (first != f->entry) status = emit_jump(jit, 0, f->entry, map, &fixups);
+
+    for (int pc = first; pc < length && status == 0; pc++) {
+        if (!f->in_func[pc]) continue;
+        if (native_offset(jit) > JIT_NATIVE_SIZE - JIT_MAX_INSN_SIZE) {
+            fprintf(stderr, "JIT Error: Native code buffer exhausted\n");
+            status = -1;
+            break;
+        }
+        map[pc] = native_offset(jit);
+
+        uint8_t opcode = jit->code[pc];
+        int next = pc + insn_length(opcode);
+        int next_start = next;
+        while (next_start < length && !f->in_func[next_start]) next_start++;
+
+        status = emit_insn(jit, f, depth, frame, pc, next_start == length, map, &fixups);
+        if (status != 0 || opcode == JMP || opcode == RET || opcode == HALT) continue;
+
+        // Keep the bytecode's fallthrough when layout order differs from it
+        if (next == length) {
+            emit_epilogue(&jit->ptr); // Fallback Epilogue: ran off the end of the code
+        } else if (next != next_start) {
+            status = emit_jump(jit, 0, next, map, &fixups);
+        }
+    }
+
+    int end = native_offset(jit);
+    for (int i = 0; status == 0 && i < fixups.n; i += 2) {
+        int target = fixups.v[i + 1];
+        patch_rel32(jit, fixups.v[i], target < 0 ? end : map[target]);
+    }
+    free(fixups.v);
+
+    if (status == 0 && depth == 0) {
+        f->map = map;
+        f->native_end = end;
+    } else {
+        free(map);
+    }
+    return status;
+}
 
-            case HALT: {
-                emit_byte(&ptr, 0x58); // pop rax (return value)
-                emit_byte(&ptr, 0x5B); // pop rbx (restore)
-                emit_byte(&ptr, 0xC9); // leave
-                emit_byte(&ptr, 0xC3); // ret
-                return (jit_func)mem;
+static void free_jit(Jit *jit) {
+    for (int i = 0; jit->funcs && i < jit->length; i++) free_func(jit->funcs[i]);
+    free(jit->funcs);
+    free(jit->queue.v);
+    free(jit->call_fixups.v);
+    free(jit->yield_fixups.v);
+    for (int t = 0; t < JIT_TRAP_COUNT; t++) free(jit->trap_fixups[t].v);
+    free(jit->relocs.v);
+}
+
+static int check_program(int length) {
+    if (length > MAX_CODE_SIZE) {
+        fprintf(stderr, "JIT Error: Program too large (%d bytes)\n", length);
+        return -1;
+    }
+    if (length <= 0) {
+        fprintf(stderr, "JIT Error: Empty program\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Emit the whole program into jit->mem (JIT_NATIVE_SIZE bytes). Returns 0 on success.
+static int emit_program(Jit *jit) {
+    jit->funcs = calloc(jit->length, sizeof(Func *));
+    uint8_t **ptr = &jit->ptr;
+
+    // 1. Prologue: Setup stack frame
+    // push rbp
+    emit_byte(ptr, 0x55);
+    // mov rbp, rsp
+    emit_byte(ptr, 0x48);
+    emit_byte(ptr, 0x89);
+    emit_byte(ptr, 0xE5);
+    // push rbx; push r12; push r13; push r14; push r15 (callee-saved)
+    emit_byte(ptr, 0x53);
+    emit_byte(ptr, 0x41); emit_byte(ptr, 0x54);
+    emit_byte(ptr, 0x41); emit_byte(ptr, 0x55);
+    emit_byte(ptr, 0x41); emit_byte(ptr, 0x56);
+    emit_byte(ptr, 0x41); emit_byte(ptr, 0x57);
+    // mov r12, rdi (runtime context)
+    emit_byte(ptr, 0x49); emit_byte(ptr, 0x89); emit_byte(ptr, 0xFC);
+    // sub rsp, rsp save slot + return stack size; mov r13, rsp (return stack grows up from here)
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x81); emit_byte(ptr, 0xEC); emit_int32(ptr, 8 + JIT_RSTACK_DEPTH * 8);
+    emit_byte(ptr, 0x49); emit_byte(ptr, 0x89); emit_byte(ptr, 0xE5);
+    // sub rsp, locals size; mov r15, rsp (frame of pc 0)
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x81); emit_byte(ptr, 0xEC); emit_int32(ptr, JIT_LOCALS_DEPTH * 8);
+    emit_byte(ptr, 0x49); emit_byte(ptr, 0x89); emit_byte(ptr, 0xE7);
+    // Zero the locals, which the GC scans: mov rdi, rsp; mov ecx, n; xor eax, eax; rep stosq
+    emit_byte(ptr, 0x48); emit_byte(ptr, 0x89); emit_byte(ptr, 0xE7);
+    emit_byte(ptr, 0xB9); emit_int32(ptr, JIT_LOCALS_DEPTH);
+    emit_byte(ptr, 0x31); emit_byte(ptr, 0xC0);
+    emit_byte(ptr, 0xF3); emit_byte(ptr, 0x48); emit_byte(ptr, 0xAB);
+    // lea r14, [rsp - operand stack size] (lowest allowed rsp)
+    emit_byte(ptr, 0x4C); emit_byte(ptr, 0x8D); emit_byte(ptr, 0xB4); emit_byte(ptr, 0x24);
+    emit_int32(ptr, -JIT_OPERAND_DEPTH * 8);
+    // Initial fuel budget
+    int status = emit_helper_call(jit, JIT_HELPER_FUEL);
+    emit_store_fuel(ptr);
+
+    // 2. Body: the code reachable from pc 0, then every out-of-line CALL target
+    Func *main_func = jit->funcs ? func_at(jit, 0) : NULL;
+    if (!main_func) status = -1;
+    if (status == 0 && main_func) {
+        main_func->queued = 1;
+        status = emit_copy(jit, main_func, 0, 0);
+    }
+    for (int i = 0; status == 0 && i < jit->queue.n; i++) {
+        Func *f = jit->funcs[jit->queue.v[i]];
+        f->native_start = native_offset(jit);
+        status = emit_copy(jit, f, 0, 0);
+    }
+
+    // 3. Trap stubs: report the error through the runtime, which does not return
+    for (int t = 0; status == 0 && t < JIT_TRAP_COUNT; t++) {
+        if (jit->trap_fixups[t].n == 0) continue;
+        if (native_offset(jit) > JIT_NATIVE_SIZE - JIT_MAX_INSN_SIZE) {
+            fprintf(stderr, "JIT Error: Native code buffer exhausted\n");
+            status = -1;
+            break;
+        }
+        int stub = native_offset(jit);
+        emit_byte(ptr, 0xBE); emit_int32(ptr, t); // mov esi, trap
+        if (emit_helper_call(jit, JIT_HELPER_TRAP) != 0) status = -1;
+        emit_byte(ptr, 0x0F); emit_byte(ptr, 0x0B); // ud2
+        for (int i = 0; i < jit->trap_fixups[t].n; i++) patch_rel32(jit, jit->trap_fixups[t].v[i], stub);
+    }
+
+    // Fuel slow paths: 'call stub; jmp back' per check, then the shared stub, which
+    // refills rbx from the runtime (which may suspend the code first)
+    if (status == 0 && jit->yield_fixups.n > 0) {
+        if (native_offset(jit) > JIT_NATIVE_SIZE - JIT_MAX_INSN_SIZE - 5 * jit->yield_fixups.n) {
+            fprintf(stderr, "JIT Error: Native code buffer exhausted\n");
+            status = -1;
+        } else {
+            int stub = native_offset(jit) + 5 * jit->yield_fixups.n;
+            for (int i = 0; i < jit->yield_fixups.n; i += 2) {
+                patch_rel32(jit, jit->yield_fixups.v[i], native_offset(jit));
+                emit_byte(ptr, 0xE8); emit_int32(ptr, stub - (native_offset(jit) + 4)); // call stub
+                emit_byte(ptr, 0xE9); emit_int32(ptr, jit->yield_fixups.v[i + 1] - (native_offset(jit) + 4)); // jmp back
             }
-            default:
-                fprintf(stderr, "JIT Error: Unsupported opcode 0x%02X\n", opcode);
-                return NULL;
+            if (emit_helper_call(jit, JIT_HELPER_YIELD) != 0) status = -1;
+            emit_store_fuel(ptr);
+            emit_byte(ptr, 0xC3); // ret
         }
     }
-    
-    // Fallback Epilogue
-    emit_byte(&ptr, 0x58); // pop rax
-    emit_byte(&ptr, 0x5B); // pop rbx
-    emit_byte(&ptr, 0xC9);
-    emit_byte(&ptr, 0xC3);
 
+    // 4. Link out-of-line calls
+    for (int i = 0; status == 0 && i < jit->call_fixups.n; i += 2) {
+        Func *callee = jit->funcs[jit->call_fixups.v[i + 1]];
+        patch_rel32(jit, jit->call_fixups.v[i], callee->map[callee->entry]);
+    }
+    return status;
+}
+
+jit_func compile(uint8_t *code, int length) {
+    if (check_program(length) != 0) return NULL;
+    if (!have_runtime) {
+        fprintf(stderr, "JIT Error: No runtime installed\n");
+        return NULL;
+    }
+
+    // Allocate executable memory
+    void *mem = mmap(NULL, JIT_NATIVE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+
+    Jit jit = { .code = code, .length = length, .mem = (uint8_t *)mem, .ptr = (uint8_t *)mem,
+                .inline_max_bytes = JIT_INLINE_MAX_BYTES };
+    if (emit_program(&jit) != 0) {
+        free_jit(&jit);
+        munmap(mem, JIT_NATIVE_SIZE);
+        return NULL;
+    }
+
+    if (perf_flags) {
+        Func *main_func = jit.funcs[0];
+        publish_perf_regions(jit.mem, main_func->map, length, 0, main_func->native_end);
+        for (int i = 0; i < jit.queue.n; i++) {
+            Func *f = jit.funcs[jit.queue.v[i]];
+            publish_perf_regions(jit.mem, f->map, length, f->native_start, f->native_end);
+        }
+    }
+    free_jit(&jit);
     return (jit_func)mem;
 }
+
+static int add_symbol(JitObject *out, int *cap, const char *name, int offset, int size, int is_function) {
+    if (out->nsyms == *cap) {
+        int n = *cap ? *cap * 2 : 16;
+        JitSymbol *syms = realloc(out->syms, n * sizeof(JitSymbol));
+        if (!syms) return -1;
+        out->syms = syms;
+        *cap = n;
+    }
+    JitSymbol *s = &out->syms[out->nsyms++];
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    s->offset = (uint32_t)offset;
+    s->size = (uint32_t)size;
+    s->is_function = is_function;
+    return 0;
+}
+
+// One symbol per out-of-line function, plus one per label compiled inside it
+static int collect_symbols(Jit *jit, const SymTab *syms, JitObject *out) {
+    int cap = 0;
+    char name[SYM_NAME_MAX + 8];
+    for (int pc = 0; pc < jit->length; pc++) {
+        Func *f = jit->funcs[pc];
+        if (!f || !f->map) continue;
+        const Symbol *label = symtab_lookup(syms, pc);
+        if (label && label->addr == pc) {
+            snprintf(name, sizeof(name), "vm:%s", label->name);
+        } else {
+            snprintf(name, sizeof(name), "vm:pc_%d", pc);
+        }
+        if (add_symbol(out, &cap, name, f->native_start, f->native_end - f->native_start, 1) != 0) return -1;
+
+        for (int i = 0; syms && i < syms->count; i++) {
+            int32_t addr = syms->syms[i].addr;
+            if (addr == pc || addr < 0 || addr >= jit->length || f->map[addr] == -1) continue;
+            snprintf(name, sizeof(name), "vm:%s", syms->syms[i].name);
+            if (add_symbol(out, &cap, name, f->map[addr], 0, 0) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+int compile_object(uint8_t *code, int length, const SymTab *syms, JitObject *out) {
+    memset(out, 0, sizeof(*out));
+    if (check_program(length) != 0) return -1;
+
+    uint8_t *mem = malloc(JIT_NATIVE_SIZE);
+    Jit jit = { .code = code, .length = length, .mem = mem, .ptr = mem,
+                .inline_max_bytes = AOT_INLINE_MAX_BYTES, .aot = 1 };
+    int status = mem ? emit_program(&jit) : -1;
+    if (status == 0) status = collect_symbols(&jit, syms, out);
+    if (status == 0) {
+        out->nrelocs = jit.relocs.n / 2;
+        out->relocs = malloc((out->nrelocs > 0 ? out->nrelocs : 1) * sizeof(JitReloc));
+        if (!out->relocs) status = -1;
+        for (int i = 0; status == 0 && i < out->nrelocs; i++) {
+            out->relocs[i].offset = (uint32_t)jit.relocs.v[2 * i];
+            out->relocs[i].helper = (JitHelper)jit.relocs.v[2 * i + 1];
+        }
+    }
+    if (status == 0) {
+        out->size = (size_t)native_offset(&jit);
+        out->code = mem;
+    } else {
+        if (!mem) fprintf(stderr, "JIT Error: Out of memory\n");
+        free(mem);
+        jit_object_free(out);
+    }
+    free_jit(&jit);
+    return status;
+}
+
+void jit_object_free(JitObject *obj) {
+    free(obj->code);
+    free(obj->relocs);
+    free(obj->syms);
+    memset(obj, 0, sizeof(*obj));
+}
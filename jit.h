@@ -3,12 +3,89 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "symtab.h"
+#include "jit_perf.h"
 
-// Function pointer type for the JIT-compiled code
-typedef int (*jit_func)();
+// Function pointer type for the JIT-compiled code. 'ctx' is passed through
+// unchanged as the first argument of every runtime helper.
+typedef int (*jit_func)(void *ctx);
+
+// Runtime helpers called from compiled code for operations that touch VM state.
+// Helpers that fail must not return (e.g. longjmp back to the caller of the jit_func).
+typedef enum {
+    JIT_HELPER_ALLOC,   // int32_t (void *ctx, int64_t size, int64_t *sp, int64_t *base)
+    JIT_HELPER_LOAD,    // int32_t (void *ctx, int64_t addr)
+    JIT_HELPER_STORE,   // void    (void *ctx, int64_t addr, int64_t val)
+    JIT_HELPER_BULK,    // int32_t (void *ctx, int op, int64_t a, int64_t b, int64_t *fuel), charges *fuel
+    JIT_HELPER_TRAP,    // void    (void *ctx, int trap), never returns
+    JIT_HELPER_PRINT,   // void    (void *ctx, int64_t val)
+    JIT_HELPER_INPUT,   // int32_t (void *ctx)
+    JIT_HELPER_FUEL,    // int32_t (void *ctx), initial fuel budget (> 0)
+    JIT_HELPER_YIELD,   // int32_t (void *ctx), budget used up: may suspend, returns the next budget (> 0)
+    JIT_HELPER_COUNT
+} JitHelper;
+
+// Link-time names of the helpers, referenced by objects from compile_object()
+extern const char *const jit_helper_symbols[JIT_HELPER_COUNT];
+
+// Errors detected by compiled code itself, reported through JIT_HELPER_TRAP
+typedef enum {
+    JIT_TRAP_STACK_OVERFLOW,    // Operand stack deeper than the interpreter's data stack
+    JIT_TRAP_RETURN_OVERFLOW,   // Too many nested CALLs
+    JIT_TRAP_RETURN_UNDERFLOW,  // RET outside of any CALL
+    JIT_TRAP_DIVISION_BY_ZERO,
+    JIT_TRAP_FRAME_OVERFLOW,    // ENTER beyond the frame-local slots
+    JIT_TRAP_INVALID_LOCAL,     // LOAD_LOCAL / STORE_LOCAL outside the current frame
+    JIT_TRAP_MISPLACED_ENTER,   // ENTER anywhere but the first instruction of a function
+    JIT_TRAP_COUNT
+} JitTrap;
+
+// For ALLOC, [sp, base) is the live native operand stack and frame-local slots, which
+// hold potential heap roots.
+typedef struct {
+    void *helpers[JIT_HELPER_COUNT];
+} JitRuntime;
+
+// Install the helpers used by later compile() calls. compile() fails until this has been called.
+void jit_set_runtime(const JitRuntime *rt);
 
 // Compile bytecode into machine code
-// Returns a pointer to the executable memory
+// Returns a pointer to the executable memory.
+// Only code reachable from pc 0 is compiled. Every CALL target becomes a native
+// function, except small non-recursive callees, which are inlined at the call site.
 jit_func compile(uint8_t *code, int length);
 
+// Ahead-of-time output: position-independent code whose helper calls go through a
+// table of JIT_HELPER_COUNT pointers, to be filled in by the linker.
+typedef struct {
+    uint32_t offset;      // rel32 field in code that addresses helpers[helper]
+    JitHelper helper;
+} JitReloc;
+
+typedef struct {
+    char name[SYM_NAME_MAX + 8];
+    uint32_t offset;
+    uint32_t size;        // 0 for labels inside a function
+    int is_function;
+} JitSymbol;
+
+typedef struct {
+    uint8_t *code;
+    size_t size;
+    JitReloc *relocs;
+    int nrelocs;
+    JitSymbol *syms;      // Compiled functions and labels, named like the perf regions
+    int nsyms;
+} JitObject;
+
+// Compile for ahead-of-time use. The entry point (pc 0) is at offset 0 and has the
+// jit_func signature. 'syms' (may be NULL) names the symbols. Returns 0 on success.
+int compile_object(uint8_t *code, int length, const SymTab *syms, JitObject *out);
+void jit_object_free(JitObject *obj);
+
+// Publish code produced by later compile() calls to perf (JIT_PERF_* flags, 0 disables).
+// Regions are named after the labels in 'syms' (may be NULL); 'source' is the assembly file
+// the .sym line table refers to (NULL: no line table).
+void jit_set_perf(int flags, const SymTab *syms, const char *source);
+
 #endif
@@ -0,0 +1,171 @@
+#include "jit_perf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// jitdump format (tools/perf/Documentation/jitdump-specification.txt in the kernel tree)
+#define JITDUMP_MAGIC    0x4A695444
+#define JITDUMP_VERSION  1
+#define JIT_CODE_LOAD        0
+#define JIT_CODE_DEBUG_INFO  2
+#define ELF_MACH_X86_64  62
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t total_size;
+    uint32_t elf_mach;
+    uint32_t pad1;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+} JitDumpHeader;
+
+typedef struct {
+    uint32_t id;
+    uint32_t total_size;
+    uint64_t timestamp;
+} JitDumpRecord;
+
+typedef struct {
+    JitDumpRecord p;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t vma;
+    uint64_t code_addr;
+    uint64_t code_size;
+    uint64_t code_index;
+    // Followed by: char name[], uint8_t code[code_size]
+} JitCodeLoad;
+
+typedef struct {
+    JitDumpRecord p;
+    uint64_t code_addr;
+    uint64_t nr_entry;
+    // Followed by nr_entry of: uint64_t addr, uint32_t line, uint32_t discrim, char name[]
+} JitDebugInfo;
+
+static FILE *perf_map = NULL;
+static FILE *jitdump = NULL;
+static uint64_t code_index = 0;
+
+// perf record -k CLOCK_MONOTONIC is required to correlate jitdump timestamps
+static uint64_t timestamp_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static FILE *open_perf_map(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/perf-%d.map", (int)getpid());
+    FILE *f = fopen(path, "a");
+    if (!f) perror(path);
+    return f;
+}
+
+static FILE *open_jitdump(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/jit-%d.dump", (int)getpid());
+    int fd = open(path, O_CREAT | O_TRUNC | O_RDWR, 0666);
+    if (fd < 0) {
+        perror(path);
+        return NULL;
+    }
+
+    // perf record notices the dump through an executable mapping of the file
+    long page = sysconf(_SC_PAGESIZE);
+    if (mmap(NULL, page, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0) == MAP_FAILED) {
+        perror("mmap jitdump");
+        close(fd);
+        return NULL;
+    }
+
+    FILE *f = fdopen(fd, "wb");
+    if (!f) {
+        close(fd);
+        return NULL;
+    }
+
+    JitDumpHeader h = {
+        .magic = JITDUMP_MAGIC,
+        .version = JITDUMP_VERSION,
+        .total_size = sizeof(JitDumpHeader),
+        .elf_mach = ELF_MACH_X86_64,
+        .pid = (uint32_t)getpid(),
+        .timestamp = timestamp_ns(),
+    };
+    fwrite(&h, sizeof(h), 1, f);
+    return f;
+}
+
+static void write_debug_info(const void *start, const JitLine *lines, int nlines, const char *source) {
+    size_t name_len = strlen(source) + 1;
+    JitDebugInfo d = {
+        .p = {
+            .id = JIT_CODE_DEBUG_INFO,
+            .total_size = (uint32_t)(sizeof(JitDebugInfo) + nlines * (16 + name_len)),
+            .timestamp = timestamp_ns(),
+        },
+        .code_addr = (uint64_t)(uintptr_t)start,
+        .nr_entry = (uint64_t)nlines,
+    };
+    fwrite(&d, sizeof(d), 1, jitdump);
+    for (int i = 0; i < nlines; i++) {
+        uint64_t addr = lines[i].addr;
+        uint32_t line = (uint32_t)lines[i].line;
+        uint32_t discrim = 0;
+        fwrite(&addr, sizeof(addr), 1, jitdump);
+        fwrite(&line, sizeof(line), 1, jitdump);
+        fwrite(&discrim, sizeof(discrim), 1, jitdump);
+        fwrite(source, 1, name_len, jitdump);
+    }
+}
+
+static void write_code_load(const char *name, const void *start, size_t size) {
+    size_t name_len = strlen(name) + 1;
+    JitCodeLoad r = {
+        .p = {
+            .id = JIT_CODE_LOAD,
+            .total_size = (uint32_t)(sizeof(JitCodeLoad) + name_len + size),
+            .timestamp = timestamp_ns(),
+        },
+        .pid = (uint32_t)getpid(),
+        .tid = (uint32_t)syscall(SYS_gettid),
+        .vma = (uint64_t)(uintptr_t)start,
+        .code_addr = (uint64_t)(uintptr_t)start,
+        .code_size = (uint64_t)size,
+        .code_index = code_index++,
+    };
+    fwrite(&r, sizeof(r), 1, jitdump);
+    fwrite(name, 1, name_len, jitdump);
+    fwrite(start, 1, size, jitdump);
+}
+
+void jit_perf_register(int flags, const char *name, const void *start, size_t size,
+                       const JitLine *lines, int nlines, const char *source) {
+    if (size == 0) return;
+
+    if (flags & JIT_PERF_MAP) {
+        if (!perf_map) perf_map = open_perf_map();
+        if (perf_map) {
+            fprintf(perf_map, "%lx %lx %s\n", (unsigned long)(uintptr_t)start, (unsigned long)size, name);
+            fflush(perf_map);
+        }
+    }
+
+    if (flags & JIT_PERF_DUMP) {
+        if (!jitdump) jitdump = open_jitdump();
+        if (jitdump) {
+            // Debug info must precede the code load it describes
+            if (nlines > 0 && source) write_debug_info(start, lines, nlines, source);
+            write_code_load(name, start, size);
+            fflush(jitdump);
+        }
+    }
+}
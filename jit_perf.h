@@ -0,0 +1,22 @@
+#ifndef JIT_PERF_H
+#define JIT_PERF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Perf Integration Flags
+#define JIT_PERF_MAP  0x1   // Append symbols to /tmp/perf-<pid>.map
+#define JIT_PERF_DUMP 0x2   // Write /tmp/jit-<pid>.dump for `perf inject --jit`
+
+// One row of the source -> native line table
+typedef struct {
+    uint64_t addr;   // Native address of the first byte emitted for the instruction
+    int32_t line;    // Line of the instruction in the assembly source
+} JitLine;
+
+// Publish one compiled region under 'name'. 'lines' covers the instructions inside it
+// and refers to lines of 'source'; without a source no line table is written.
+void jit_perf_register(int flags, const char *name, const void *start, size_t size,
+                       const JitLine *lines, int nlines, const char *source);
+
+#endif
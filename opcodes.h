@@ -22,12 +22,27 @@
 // Memory & Functions
 #define STORE 0x30
 #define LOAD  0x31
+#define LOADI  0x32   // Indexed load:  [addr] -> [Memory[addr]]
+#define STOREI 0x33   // Indexed store: [val, addr] -> []
+#define LOAD_LOCAL  0x34  // [] -> [locals[idx]] in the current frame
+#define STORE_LOCAL 0x35  // [val] -> []
 #define CALL  0x40
 #define RET   0x41
+#define ENTER 0x42    // Give the current frame n zeroed local slots (only as the first instruction of a function)
 
 // Standard Library
 #define PRINT 0x50
 #define INPUT 0x51
 #define ALLOC 0x60
 
+// Bulk Array Operations (operands are object addresses returned by ALLOC;
+// binary operations cover the shorter of the two objects)
+#define AFILL 0x70   // [obj, val] -> []       obj[i] = val
+#define ACOPY 0x71   // [dst, src] -> []       dst[i] = src[i]
+#define ASUM  0x72   // [obj] -> [sum]
+#define AMIN  0x73   // [obj] -> [min]         (error on empty object)
+#define AMAX  0x74   // [obj] -> [max]         (error on empty object)
+#define AADD  0x75   // [dst, src] -> []       dst[i] += src[i]
+#define AMUL  0x76   // [dst, src] -> []       dst[i] *= src[i]
+
 #endif
\ No newline at end of file
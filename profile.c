@@ -0,0 +1,222 @@
+#include "profile.h"
+#include "opcodes.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int key;          // Opcode, pc or label index
+    uint64_t count;
+} Row;
+
+static const char *opcode_name(uint8_t op) {
+    switch (op) {
+        case PUSH: return "PUSH";   case POP: return "POP";     case DUP: return "DUP";
+        case HALT: return "HALT";   case ADD: return "ADD";     case SUB: return "SUB";
+        case MUL: return "MUL";     case DIV: return "DIV";     case CMP: return "CMP";
+        case JMP: return "JMP";     case JZ: return "JZ";       case JNZ: return "JNZ";
+        case STORE: return "STORE"; case LOAD: return "LOAD";   case CALL: return "CALL";
+        case RET: return "RET";     case PRINT: return "PRINT"; case INPUT: return "INPUT";
+        case ALLOC: return "ALLOC";
+        case LOADI: return "LOADI"; case STOREI: return "STOREI";
+        case LOAD_LOCAL: return "LOAD_LOCAL"; case STORE_LOCAL: return "STORE_LOCAL";
+        case ENTER: return "ENTER";
+        case AFILL: return "AFILL"; case ACOPY: return "ACOPY"; case ASUM: return "ASUM";
+        case AMIN: return "AMIN";   case AMAX: return "AMAX";   case AADD: return "AADD";
+        case AMUL: return "AMUL";
+        default: return "???";
+    }
+}
+
+Profile *profile_create(int code_size) {
+    Profile *prof = calloc(1, sizeof(Profile));
+    if (!prof) return NULL;
+    prof->code_size = code_size;
+    prof->pc_counts = calloc(code_size + 1, sizeof(uint64_t));
+    prof->backedge_counts = calloc(code_size + 1, sizeof(uint64_t));
+    prof->call_counts = calloc(code_size + 1, sizeof(uint64_t));
+    if (!prof->pc_counts || !prof->backedge_counts || !prof->call_counts) {
+        profile_free(prof);
+        return NULL;
+    }
+    return prof;
+}
+
+void profile_free(Profile *prof) {
+    if (!prof) return;
+    free(prof->pc_counts);
+    free(prof->backedge_counts);
+    free(prof->call_counts);
+    free(prof);
+}
+
+static int cmp_row_desc(const void *a, const void *b) {
+    const Row *ra = (const Row *)a;
+    const Row *rb = (const Row *)b;
+    if (ra->count != rb->count) return (ra->count < rb->count) ? 1 : -1;
+    return ra->key - rb->key; // Ties in program order
+}
+
+// Collect the non-zero entries of 'counts' sorted by count. Caller frees.
+static Row *sorted_rows(const uint64_t *counts, int n, int *out_n) {
+    Row *rows = malloc((n > 0 ? n : 1) * sizeof(Row));
+    int k = 0;
+    if (rows) {
+        for (int i = 0; i < n; i++) {
+            if (counts[i]) {
+                rows[k].key = i;
+                rows[k].count = counts[i];
+                k++;
+            }
+        }
+        qsort(rows, k, sizeof(Row), cmp_row_desc);
+    }
+    *out_n = k;
+    return rows;
+}
+
+// Sum pc counts per label region [label, next label). Index == syms->count is code before the first label.
+static uint64_t *label_totals(const Profile *prof, const SymTab *syms) {
+    int n = syms ? syms->count : 0;
+    uint64_t *totals = calloc(n + 1, sizeof(uint64_t));
+    if (!totals) return NULL;
+    for (int pc = 0; pc < prof->code_size; pc++) {
+        if (!prof->pc_counts[pc]) continue;
+        const Symbol *s = symtab_lookup(syms, pc);
+        totals[s ? (int)(s - syms->syms) : n] += prof->pc_counts[pc];
+    }
+    return totals;
+}
+
+static double percent(uint64_t part, uint64_t total) {
+    return total ? 100.0 * (double)part / (double)total : 0.0;
+}
+
+static uint64_t total_insns(const Profile *prof) {
+    uint64_t total = 0;
+    for (int i = 0; i < 256; i++) total += prof->op_counts[i];
+    return total;
+}
+
+static void report_pc_section(const char *title, const uint64_t *counts, const Profile *prof,
+                              const SymTab *syms, FILE *out, int limit) {
+    int n;
+    Row *rows = sorted_rows(counts, prof->code_size, &n);
+    if (!rows || n == 0) { free(rows); return; }
+
+    char where[96];
+    fprintf(out, "\n%s\n", title);
+    for (int i = 0; i < n && i < limit; i++) {
+        symtab_format(syms, rows[i].key, where, sizeof(where));
+        fprintf(out, "  %6d  %-24s %14llu\n", rows[i].key, where, (unsigned long long)rows[i].count);
+    }
+    free(rows);
+}
+
+void profile_report(const Profile *prof, const uint8_t *code, const SymTab *syms, FILE *out, int limit) {
+    uint64_t total = total_insns(prof);
+    int n;
+    char where[96];
+
+    fprintf(out, "\n=== Profile: %llu instructions in %.6fs (%.1f MIPS) ===\n",
+            (unsigned long long)total, prof->elapsed,
+            prof->elapsed > 0 ? (double)total / prof->elapsed / 1e6 : 0.0);
+
+    Row *rows = sorted_rows(prof->op_counts, 256, &n);
+    if (rows) {
+        fprintf(out, "\nOpcodes\n");
+        for (int i = 0; i < n && i < limit; i++) {
+            fprintf(out, "  %-8s %14llu  %5.1f%%\n", opcode_name((uint8_t)rows[i].key),
+                    (unsigned long long)rows[i].count, percent(rows[i].count, total));
+        }
+        free(rows);
+    }
+
+    uint64_t *totals = label_totals(prof, syms);
+    if (totals) {
+        int nlabels = syms ? syms->count : 0;
+        rows = sorted_rows(totals, nlabels + 1, &n);
+        if (rows) {
+            fprintf(out, "\nLabels\n");
+            for (int i = 0; i < n && i < limit; i++) {
+                const char *name = rows[i].key < nlabels ? syms->syms[rows[i].key].name : "(entry)";
+                fprintf(out, "  %-24s %14llu  %5.1f%%\n", name,
+                        (unsigned long long)rows[i].count, percent(rows[i].count, total));
+            }
+            free(rows);
+        }
+        free(totals);
+    }
+
+    rows = sorted_rows(prof->pc_counts, prof->code_size, &n);
+    if (rows) {
+        fprintf(out, "\nHot instructions\n");
+        for (int i = 0; i < n && i < limit; i++) {
+            symtab_format(syms, rows[i].key, where, sizeof(where));
+            fprintf(out, "  %6d  %-24s %-8s %14llu  %5.1f%%\n", rows[i].key, where,
+                    opcode_name(code[rows[i].key]), (unsigned long long)rows[i].count,
+                    percent(rows[i].count, total));
+        }
+        free(rows);
+    }
+
+    report_pc_section("Back-edge targets (loop headers)", prof->backedge_counts, prof, syms, out, limit);
+    report_pc_section("CALL targets", prof->call_counts, prof, syms, out, limit);
+}
+
+static void json_pc_array(FILE *f, const char *key, const uint64_t *counts, const Profile *prof,
+                          const uint8_t *code, const SymTab *syms, int with_op) {
+    int n;
+    char where[96];
+    Row *rows = sorted_rows(counts, prof->code_size, &n);
+    fprintf(f, "  \"%s\": [", key);
+    for (int i = 0; rows && i < n; i++) {
+        // Labels are assembler identifiers, so they need no JSON escaping
+        symtab_format(syms, rows[i].key, where, sizeof(where));
+        fprintf(f, "%s\n    {\"pc\": %d, \"label\": \"%s\", ", i ? "," : "", rows[i].key, where);
+        if (with_op) fprintf(f, "\"op\": \"%s\", ", opcode_name(code[rows[i].key]));
+        fprintf(f, "\"count\": %llu}", (unsigned long long)rows[i].count);
+    }
+    fprintf(f, "%s]", n ? "\n  " : "");
+    free(rows);
+}
+
+int profile_write_json(const Profile *prof, const uint8_t *code, const SymTab *syms, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+
+    int n;
+    fprintf(f, "{\n  \"total_instructions\": %llu,\n  \"elapsed_s\": %.9f,\n",
+            (unsigned long long)total_insns(prof), prof->elapsed);
+
+    Row *rows = sorted_rows(prof->op_counts, 256, &n);
+    fprintf(f, "  \"opcodes\": [");
+    for (int i = 0; rows && i < n; i++) {
+        fprintf(f, "%s\n    {\"op\": \"%s\", \"code\": %d, \"count\": %llu}", i ? "," : "",
+                opcode_name((uint8_t)rows[i].key), rows[i].key, (unsigned long long)rows[i].count);
+    }
+    fprintf(f, "%s],\n", n ? "\n  " : "");
+    free(rows);
+
+    uint64_t *totals = label_totals(prof, syms);
+    int nlabels = syms ? syms->count : 0;
+    rows = totals ? sorted_rows(totals, nlabels + 1, &n) : NULL;
+    fprintf(f, "  \"labels\": [");
+    for (int i = 0; rows && i < n; i++) {
+        int has_label = rows[i].key < nlabels;
+        fprintf(f, "%s\n    {\"label\": \"%s\", \"pc\": %d, \"count\": %llu}", i ? "," : "",
+                has_label ? syms->syms[rows[i].key].name : "(entry)",
+                has_label ? syms->syms[rows[i].key].addr : 0, (unsigned long long)rows[i].count);
+    }
+    fprintf(f, "%s],\n", (rows && n) ? "\n  " : "");
+    free(rows);
+    free(totals);
+
+    json_pc_array(f, "pcs", prof->pc_counts, prof, code, syms, 1);
+    fprintf(f, ",\n");
+    json_pc_array(f, "back_edges", prof->backedge_counts, prof, code, syms, 0);
+    fprintf(f, ",\n");
+    json_pc_array(f, "call_targets", prof->call_counts, prof, code, syms, 0);
+    fprintf(f, "\n}\n");
+
+    return fclose(f) == 0 ? 0 : -1;
+}
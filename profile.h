@@ -0,0 +1,40 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "symtab.h"
+
+// Execution profile collected by the interpreter's profiled dispatch loop
+typedef struct {
+    int code_size;
+    uint64_t op_counts[256];      // Executions per opcode
+    uint64_t *pc_counts;          // Executions per bytecode offset
+    uint64_t *backedge_counts;    // Taken backward branches, indexed by target pc (loop headers)
+    uint64_t *call_counts;        // CALLs, indexed by target pc (function entries)
+    double elapsed;               // Wall-clock seconds spent in the loop
+} Profile;
+
+Profile *profile_create(int code_size);
+void profile_free(Profile *prof);
+
+// Hooks used by the profiled loop. pc is the offset of the instruction itself.
+static inline void profile_insn(Profile *prof, int pc, uint8_t opcode) {
+    prof->op_counts[opcode]++;
+    if ((unsigned)pc < (unsigned)prof->code_size) prof->pc_counts[pc]++;
+}
+
+static inline void profile_branch(Profile *prof, int pc, int target) {
+    if (target <= pc && (unsigned)target < (unsigned)prof->code_size) prof->backedge_counts[target]++;
+}
+
+static inline void profile_call(Profile *prof, int target) {
+    if ((unsigned)target < (unsigned)prof->code_size) prof->call_counts[target]++;
+}
+
+// Sorted hot-spot report (top 'limit' rows per section), pcs mapped to labels
+void profile_report(const Profile *prof, const uint8_t *code, const SymTab *syms, FILE *out, int limit);
+// Full profile as JSON. Returns 0 on success, -1 on I/O error.
+int profile_write_json(const Profile *prof, const uint8_t *code, const SymTab *syms, const char *path);
+
+#endif
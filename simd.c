@@ -0,0 +1,232 @@
+#include "simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// --- Scalar Fallback ---
+
+static void scalar_fill(int32_t *dst, int32_t val, int n) {
+    for (int i = 0; i < n; i++) dst[i] = val;
+}
+
+static void scalar_copy(int32_t *dst, const int32_t *src, int n) {
+    memmove(dst, src, (size_t)n * sizeof(int32_t));
+}
+
+static int32_t scalar_sum(const int32_t *src, int n) {
+    uint32_t acc = 0;
+    for (int i = 0; i < n; i++) acc += (uint32_t)src[i];
+    return (int32_t)acc;
+}
+
+static int32_t scalar_min(const int32_t *src, int n) {
+    int32_t m = src[0];
+    for (int i = 1; i < n; i++) if (src[i] < m) m = src[i];
+    return m;
+}
+
+static int32_t scalar_max(const int32_t *src, int n) {
+    int32_t m = src[0];
+    for (int i = 1; i < n; i++) if (src[i] > m) m = src[i];
+    return m;
+}
+
+static void scalar_add(int32_t *dst, const int32_t *src, int n) {
+    for (int i = 0; i < n; i++) dst[i] = (int32_t)((uint32_t)dst[i] + (uint32_t)src[i]);
+}
+
+static void scalar_mul(int32_t *dst, const int32_t *src, int n) {
+    for (int i = 0; i < n; i++) dst[i] = (int32_t)((uint32_t)dst[i] * (uint32_t)src[i]);
+}
+
+static const SimdKernels scalar_kernels = {
+    "scalar", scalar_fill, scalar_copy, scalar_sum, scalar_min, scalar_max, scalar_add, scalar_mul,
+};
+
+#if defined(__x86_64__)
+
+// --- SSE2 (baseline on x86_64) ---
+
+static void sse2_fill(int32_t *dst, int32_t val, int n) {
+    __m128i v = _mm_set1_epi32(val);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i *)(dst + i), v);
+    for (; i < n; i++) dst[i] = val;
+}
+
+static int32_t sse2_sum(const int32_t *src, int n) {
+    __m128i acc = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) acc = _mm_add_epi32(acc, _mm_loadu_si128((const __m128i *)(src + i)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t total = (uint32_t)_mm_cvtsi128_si32(acc);
+    for (; i < n; i++) total += (uint32_t)src[i];
+    return (int32_t)total;
+}
+
+// SSE2 has no pminsd/pmaxsd (SSE4.1): select with a compare mask instead
+static inline __m128i sse2_select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static int32_t sse2_min(const int32_t *src, int n) {
+    if (n < 4) return scalar_min(src, n);
+    __m128i m = _mm_loadu_si128((const __m128i *)src);
+    int i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        m = sse2_select(_mm_cmplt_epi32(v, m), v, m);
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, m);
+    int32_t r = scalar_min(lanes, 4);
+    for (; i < n; i++) if (src[i] < r) r = src[i];
+    return r;
+}
+
+static int32_t sse2_max(const int32_t *src, int n) {
+    if (n < 4) return scalar_max(src, n);
+    __m128i m = _mm_loadu_si128((const __m128i *)src);
+    int i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        m = sse2_select(_mm_cmpgt_epi32(v, m), v, m);
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, m);
+    int32_t r = scalar_max(lanes, 4);
+    for (; i < n; i++) if (src[i] > r) r = src[i];
+    return r;
+}
+
+static void sse2_add(int32_t *dst, const int32_t *src, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi32(a, b));
+    }
+    for (; i < n; i++) dst[i] = (int32_t)((uint32_t)dst[i] + (uint32_t)src[i]);
+}
+
+// SSE2 has no 32-bit pmulld: multiply even and odd lanes with pmuludq and re-interleave
+static void sse2_mul(int32_t *dst, const int32_t *src, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        __m128i r = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                       _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        _mm_storeu_si128((__m128i *)(dst + i), r);
+    }
+    for (; i < n; i++) dst[i] = (int32_t)((uint32_t)dst[i] * (uint32_t)src[i]);
+}
+
+static const SimdKernels sse2_kernels = {
+    "sse2", sse2_fill, scalar_copy, sse2_sum, sse2_min, sse2_max, sse2_add, sse2_mul,
+};
+
+// --- AVX2 ---
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static void avx2_fill(int32_t *dst, int32_t val, int n) {
+    __m256i v = _mm256_set1_epi32(val);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_si256((__m256i *)(dst + i), v);
+    for (; i < n; i++) dst[i] = val;
+}
+
+AVX2 static int32_t avx2_sum(const int32_t *src, int n) {
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) acc = _mm256_add_epi32(acc, _mm256_loadu_si256((const __m256i *)(src + i)));
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t total = (uint32_t)_mm_cvtsi128_si32(half);
+    for (; i < n; i++) total += (uint32_t)src[i];
+    return (int32_t)total;
+}
+
+AVX2 static int32_t avx2_min(const int32_t *src, int n) {
+    if (n < 8) return scalar_min(src, n);
+    __m256i m = _mm256_loadu_si256((const __m256i *)src);
+    int i = 8;
+    for (; i + 8 <= n; i += 8) m = _mm256_min_epi32(m, _mm256_loadu_si256((const __m256i *)(src + i)));
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, m);
+    int32_t r = scalar_min(lanes, 8);
+    for (; i < n; i++) if (src[i] < r) r = src[i];
+    return r;
+}
+
+AVX2 static int32_t avx2_max(const int32_t *src, int n) {
+    if (n < 8) return scalar_max(src, n);
+    __m256i m = _mm256_loadu_si256((const __m256i *)src);
+    int i = 8;
+    for (; i + 8 <= n; i += 8) m = _mm256_max_epi32(m, _mm256_loadu_si256((const __m256i *)(src + i)));
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, m);
+    int32_t r = scalar_max(lanes, 8);
+    for (; i < n; i++) if (src[i] > r) r = src[i];
+    return r;
+}
+
+AVX2 static void avx2_add(int32_t *dst, const int32_t *src, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_add_epi32(a, b));
+    }
+    for (; i < n; i++) dst[i] = (int32_t)((uint32_t)dst[i] + (uint32_t)src[i]);
+}
+
+AVX2 static void avx2_mul(int32_t *dst, const int32_t *src, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_mullo_epi32(a, b));
+    }
+    for (; i < n; i++) dst[i] = (int32_t)((uint32_t)dst[i] * (uint32_t)src[i]);
+}
+
+static const SimdKernels avx2_kernels = {
+    "avx2", avx2_fill, scalar_copy, avx2_sum, avx2_min, avx2_max, avx2_add, avx2_mul,
+};
+
+#endif // __x86_64__
+
+static const SimdKernels *selected = NULL;
+
+const SimdKernels *simd_kernel_set(const char *name) {
+    if (strcmp(name, "scalar") == 0) return &scalar_kernels;
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (strcmp(name, "sse2") == 0) return &sse2_kernels; // Baseline on x86-64
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) return &avx2_kernels;
+#endif
+    return NULL;
+}
+
+static const SimdKernels *select_kernels(void) {
+    const char *force = getenv("VM_SIMD");
+    const SimdKernels *k = force ? simd_kernel_set(force) : NULL;
+    if (k) return k;
+    if ((k = simd_kernel_set("avx2"))) return k;
+    if ((k = simd_kernel_set("sse2"))) return k;
+    return &scalar_kernels;
+}
+
+const SimdKernels *simd_kernels(void) {
+    if (!selected) selected = select_kernels();
+    return selected;
+}
@@ -0,0 +1,26 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stdint.h>
+
+// Element-wise kernels over int32 arrays, used by the bulk heap opcodes.
+// All arithmetic wraps modulo 2^32, like the scalar ADD/MUL opcodes.
+typedef struct {
+    const char *name;
+    void (*fill)(int32_t *dst, int32_t val, int n);
+    void (*copy)(int32_t *dst, const int32_t *src, int n);
+    int32_t (*sum)(const int32_t *src, int n);
+    int32_t (*min)(const int32_t *src, int n);   // n > 0
+    int32_t (*max)(const int32_t *src, int n);   // n > 0
+    void (*add)(int32_t *dst, const int32_t *src, int n);
+    void (*mul)(int32_t *dst, const int32_t *src, int n);
+} SimdKernels;
+
+// Best kernel set for this CPU (AVX2 > SSE2 > scalar), chosen by CPUID on first use.
+// The VM_SIMD environment variable (scalar, sse2, avx2) forces a specific set.
+const SimdKernels *simd_kernels(void);
+
+// Kernel set by name ("scalar", "sse2", "avx2"), or NULL if this CPU cannot run it
+const SimdKernels *simd_kernel_set(const char *name);
+
+#endif
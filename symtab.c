@@ -0,0 +1,124 @@
+#include "symtab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int symtab_load(SymTab *tab, const char *path) {
+    tab->syms = NULL;
+    tab->count = 0;
+    tab->lines = NULL;
+    tab->line_count = 0;
+
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    int cap = 0, line_cap = 0;
+    int32_t addr;
+    char name[SYM_NAME_MAX];
+    while (fscanf(f, "%d %63s", &addr, name) == 2) {
+        if (name[0] == '@') {
+            if (tab->line_count == line_cap) {
+                line_cap = line_cap ? line_cap * 2 : 64;
+                SourceLine *grown = realloc(tab->lines, line_cap * sizeof(SourceLine));
+                if (!grown) break;
+                tab->lines = grown;
+            }
+            tab->lines[tab->line_count].addr = addr;
+            tab->lines[tab->line_count].line = atoi(name + 1);
+            tab->line_count++;
+            continue;
+        }
+        if (tab->count == cap) {
+            cap = cap ? cap * 2 : 16;
+            Symbol *grown = realloc(tab->syms, cap * sizeof(Symbol));
+            if (!grown) break;
+            tab->syms = grown;
+        }
+        tab->syms[tab->count].addr = addr;
+        strcpy(tab->syms[tab->count].name, name);
+        tab->count++;
+    }
+    fclose(f);
+
+    // Stable insertion sort: for labels sharing an address, the first one in the file wins.
+    // The assembler already writes the table in order, so this is normally a single pass.
+    for (int i = 1; i < tab->count; i++) {
+        Symbol key = tab->syms[i];
+        int j = i - 1;
+        while (j >= 0 && tab->syms[j].addr > key.addr) {
+            tab->syms[j + 1] = tab->syms[j];
+            j--;
+        }
+        tab->syms[j + 1] = key;
+    }
+    return 0;
+}
+
+void symtab_free(SymTab *tab) {
+    free(tab->syms);
+    free(tab->lines);
+    tab->syms = NULL;
+    tab->count = 0;
+    tab->lines = NULL;
+    tab->line_count = 0;
+}
+
+const Symbol *symtab_lookup(const SymTab *tab, int32_t pc) {
+    if (!tab || tab->count == 0) return NULL;
+
+    // Binary search for the last symbol with addr <= pc
+    int lo = 0, hi = tab->count - 1, found = -1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (tab->syms[mid].addr <= pc) {
+            found = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    if (found < 0) return NULL;
+    // Walk back to the first label at this address
+    while (found > 0 && tab->syms[found - 1].addr == tab->syms[found].addr) found--;
+    return &tab->syms[found];
+}
+
+const Symbol *symtab_find(const SymTab *tab, const char *name) {
+    if (!tab) return NULL;
+    for (int i = 0; i < tab->count; i++) {
+        if (strcmp(tab->syms[i].name, name) == 0) return &tab->syms[i];
+    }
+    return NULL;
+}
+
+int32_t symtab_source_line(const SymTab *tab, int32_t pc) {
+    if (!tab) return -1;
+    int lo = 0, hi = tab->line_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (tab->lines[mid].addr == pc) return tab->lines[mid].line;
+        if (tab->lines[mid].addr < pc) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+void symtab_format(const SymTab *tab, int32_t pc, char *buf, int len) {
+    const Symbol *s = symtab_lookup(tab, pc);
+    if (!s) {
+        snprintf(buf, len, "pc_%d", pc);
+    } else if (s->addr == pc) {
+        snprintf(buf, len, "%s", s->name);
+    } else {
+        snprintf(buf, len, "%s+%d", s->name, pc - s->addr);
+    }
+}
+
+void symtab_default_path(const char *bin_path, char *buf, int len) {
+    size_t n = strlen(bin_path);
+    if (n > 4 && strcmp(bin_path + n - 4, ".bin") == 0) {
+        snprintf(buf, len, "%.*s.sym", (int)(n - 4), bin_path);
+    } else {
+        snprintf(buf, len, "%s.sym", bin_path);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+#include <stdint.h>
+
+#define SYM_NAME_MAX 64
+
+// Assembler label: bytecode offset -> name
+typedef struct {
+    int32_t addr;
+    char name[SYM_NAME_MAX];
+} Symbol;
+
+// Source line of the instruction at a bytecode offset
+typedef struct {
+    int32_t addr;
+    int32_t line;
+} SourceLine;
+
+// Symbol table loaded from the assembler's .sym file, sorted by address
+typedef struct {
+    Symbol *syms;
+    int count;
+    SourceLine *lines; // Line table, in address order (empty for older .sym files)
+    int line_count;
+} SymTab;
+
+// Load "<addr> <name>" label lines and "<addr> @<line>" line-table entries.
+// Returns 0 on success, -1 if the file can't be read.
+int symtab_load(SymTab *tab, const char *path);
+void symtab_free(SymTab *tab);
+
+// Label covering 'pc' (the closest one at or before it), or NULL
+const Symbol *symtab_lookup(const SymTab *tab, int32_t pc);
+// Label by name, or NULL
+const Symbol *symtab_find(const SymTab *tab, const char *name);
+
+// Source line of the instruction at 'pc', or -1 if the table doesn't cover it
+int32_t symtab_source_line(const SymTab *tab, int32_t pc);
+
+// Format pc as "LABEL+off" (or "pc_<n>" when no label covers it)
+void symtab_format(const SymTab *tab, int32_t pc, char *buf, int len);
+
+// Derive the default symbol file path for a bytecode file: "prog.bin" -> "prog.sym"
+void symtab_default_path(const char *bin_path, char *buf, int len);
+
+#endif
@@ -0,0 +1,15 @@
+; Test Bulk Array Operation on an Interior Pointer
+; A's payload words all hold 2, so A+4 looks like an object whose header (A[1]) says
+; "2 words". It is not an ALLOC result and must be rejected, not filled across A.
+; Expected: Runtime Error "Invalid Array Address"
+
+PUSH 8
+ALLOC         ; A
+DUP
+PUSH 2
+AFILL         ; A[i] = 2
+PUSH 4
+ADD           ; A + 4
+PUSH 99
+AFILL
+HALT
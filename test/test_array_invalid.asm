@@ -0,0 +1,6 @@
+; Test Bulk Array Operation on a Non-Object Address
+; Expected: Runtime Error "Invalid Array Address"
+
+PUSH 5        ; Data memory address, not an ALLOC result
+ASUM
+HALT
@@ -0,0 +1,46 @@
+; Test Bulk Array Operations (AFILL, ACOPY, AADD, AMUL, ASUM, AMIN, AMAX)
+; Expected Result: 236
+
+PUSH 10
+ALLOC
+STORE 0       ; a = 10 words
+PUSH 10
+ALLOC
+STORE 1       ; b = 10 words
+PUSH 4
+ALLOC
+STORE 2       ; c = 4 words
+
+LOAD 0
+PUSH 3
+AFILL         ; a = [3, 3, ...]
+LOAD 1
+PUSH 2
+AFILL         ; b = [2, 2, ...]
+LOAD 0
+LOAD 1
+AMUL          ; a = [6, 6, ...]
+
+LOAD 2
+LOAD 0
+ACOPY         ; c = a[0..3] = [6, 6, 6, 6]
+
+PUSH 100
+LOAD 0
+PUSH 3
+ADD
+STOREI        ; a[3] = 100
+
+LOAD 2
+LOAD 0
+AADD          ; c = [12, 12, 12, 106]
+
+LOAD 2
+ASUM          ; 142
+LOAD 2
+AMAX          ; 106
+ADD
+LOAD 2
+AMIN          ; 12
+SUB           ; 142 + 106 - 12 = 236
+HALT
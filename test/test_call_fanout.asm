@@ -0,0 +1,60 @@
+; Call tree with fan-out 9 and depth 5: every path ends in E, which adds 1
+; Inlining each level into the one above multiplies code size by 9 per level
+; Expected Result: 6561
+
+PUSH 0
+CALL A
+HALT
+
+A:
+    CALL B
+    CALL B
+    CALL B
+    CALL B
+    CALL B
+    CALL B
+    CALL B
+    CALL B
+    CALL B
+    RET
+
+B:
+    CALL C
+    CALL C
+    CALL C
+    CALL C
+    CALL C
+    CALL C
+    CALL C
+    CALL C
+    CALL C
+    RET
+
+C:
+    CALL D
+    CALL D
+    CALL D
+    CALL D
+    CALL D
+    CALL D
+    CALL D
+    CALL D
+    CALL D
+    RET
+
+D:
+    CALL E
+    CALL E
+    CALL E
+    CALL E
+    CALL E
+    CALL E
+    CALL E
+    CALL E
+    CALL E
+    RET
+
+E:
+    PUSH 1
+    ADD
+    RET
@@ -0,0 +1,11 @@
+; Test Error: ENTER after the first instruction of a function
+; Expected: the assembler refuses the program
+
+CALL F
+HALT
+
+F:
+    PUSH 1
+    ENTER 1         ; Frames are sized at function entry only
+    STORE_LOCAL 0
+    RET
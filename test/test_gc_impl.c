@@ -33,6 +33,7 @@ Obj new_pair(Obj a, Obj b) {
     current_vm->heap[addr + 2] = 0;                    
     
     current_vm->allocated_list = addr;                 
+    heap_set_start(current_vm, addr);
     current_vm->free_ptr += needed;                    
     
     int32_t payload_addr = addr + 3;
@@ -63,7 +64,7 @@ int count_allocated_objects(VM *vm) {
 }
 
 void reset_vm(VM *vm) {
-    memset(vm, 0, sizeof(VM));
+    vm_init(vm);
     vm->free_ptr = 0;
     vm->allocated_list = -1;
     vm->sp = -1;
@@ -219,6 +220,319 @@ void test_gc_stress_allocation() {
     assert(failures == 0);
 }
 
+// GC Telemetry Records
+void test_gc_telemetry_records() {
+    printf("\n=== Test: GC Telemetry Records ===\n");
+    VM vm; reset_vm(&vm);
+
+    Obj live = new_pair(0, 0);
+    new_pair(0, 0); // Garbage
+    push(&vm, VAL_OBJ(live));
+
+    gc(&vm);
+    gc(&vm);
+
+    // Outcome: one record per cycle; first cycle frees the garbage pair
+    assert(vm_gc_record_count(&vm) == 2);
+    const GCRecord *r = vm_gc_record(&vm, 0);
+    printf("  Result: marked %d, freed %d, heap %d -> live %d words.\n",
+           r->objects_marked, r->objects_freed, r->heap_words_before, r->live_words_after);
+    assert(r->cycle == 1);
+    assert(r->objects_marked == 1);
+    assert(r->objects_freed == 1);
+    assert(r->heap_words_before == 10);
+    assert(r->live_words_after == 5);
+    assert(r->pause >= r->mark_time && r->pause >= r->sweep_time);
+    assert(vm_gc_record(&vm, 1)->objects_freed == 0);
+    assert(vm_gc_record(&vm, 2) == NULL);
+
+    GCPauseSummary pauses;
+    vm_gc_pause_summary(&vm, &pauses);
+    assert(pauses.count == 2);
+    assert(pauses.p50 <= pauses.p99 && pauses.p99 <= pauses.max);
+    free(vm.gc_records);
+}
+
+// Frame Locals as Roots
+void test_gc_frame_locals_are_roots() {
+    printf("\n=== Test: Frame Locals as Roots ===\n");
+    VM vm; reset_vm(&vm);
+
+    Obj a = new_pair(0, 0);
+    vm.locals[0] = VAL_OBJ(a);  // Only reference: slot 0 of the live frame
+    vm.frame_top = 1;
+    gc(&vm);
+    assert(count_allocated_objects(&vm) == 1);
+
+    vm.frame_top = 0;           // Frame popped: the slot is no longer a root
+    gc(&vm);
+    int count = count_allocated_objects(&vm);
+    printf("  Result: %d objects remaining.\n", count);
+    assert(count == 0);
+}
+
+// A stack value pointing into the middle of an object is not a root
+void test_gc_interior_pointer_root() {
+    printf("\n=== Test: Interior Pointer Root ===\n");
+    VM vm; reset_vm(&vm);
+
+    Obj a = new_pair(1, 0);
+    int32_t a_idx = (int32_t)a - MEM_SIZE;
+    // Seen as an object, a's mark word (0) would be its size and a[1] its mark word
+    push(&vm, (int32_t)a + 2);
+    push(&vm, VAL_OBJ(a));
+    gc(&vm);
+
+    printf("  Result: a = [%d, %d], %d objects remaining.\n",
+           vm.heap[a_idx], vm.heap[a_idx + 1], count_allocated_objects(&vm));
+    assert(vm.heap[a_idx] == 1 && vm.heap[a_idx + 1] == 0);
+    assert(count_allocated_objects(&vm) == 1);
+}
+
+void test_simd_kernels_match_scalar() {
+    printf("\n=== Test: SIMD Kernels Match Scalar ===\n");
+    const char *names[] = { "sse2", "avx2" };
+    const SimdKernels *ref = simd_kernel_set("scalar");
+    int32_t src[67], a[67], b[67];
+    for (int i = 0; i < 67; i++) src[i] = (i * 2654435761u) ^ (i << 20); // Mixed signs, large products
+
+    for (int k = 0; k < 2; k++) {
+        const SimdKernels *ks = simd_kernel_set(names[k]);
+        if (!ks) {
+            printf("  Skipped %s (not supported by this CPU).\n", names[k]);
+            continue;
+        }
+        // Every length up to several vectors, so all tail paths run
+        for (int n = 1; n <= 67; n++) {
+            assert(ks->sum(src, n) == ref->sum(src, n));
+            assert(ks->min(src, n) == ref->min(src, n));
+            assert(ks->max(src, n) == ref->max(src, n));
+            for (int i = 0; i < 67; i++) a[i] = b[i] = src[66 - i];
+            ks->add(a, src, n); ref->add(b, src, n);
+            assert(memcmp(a, b, sizeof(a)) == 0);
+            ks->mul(a, src, n); ref->mul(b, src, n);
+            assert(memcmp(a, b, sizeof(a)) == 0);
+            ks->fill(a, -7, n); ref->fill(b, -7, n);
+            assert(memcmp(a, b, sizeof(a)) == 0);
+        }
+        printf("  Result: %s matches scalar.\n", ks->name);
+    }
+}
+
+void test_snapshot_round_trip() {
+    printf("\n=== Test: Snapshot Round Trip ===\n");
+    uint8_t code[] = { PUSH, 1, 0, 0, 0, HALT };
+    uint8_t other[] = { PUSH, 2, 0, 0, 0, HALT };
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/vm_snapshot_test_%d.snap", (int)getpid());
+
+    VM vm; reset_vm(&vm);
+    vm.code = code; vm.code_size = sizeof(code); vm.pc = 5;
+    Obj pair = new_pair(11, 22);
+    push(&vm, VAL_OBJ(pair));
+    vm.memory[7] = 99;
+    assert(vm_snapshot_write(&vm, path) == 0);
+
+    VM restored; reset_vm(&restored);
+    restored.code = code; restored.code_size = sizeof(code);
+    assert(vm_snapshot_restore(&restored, path) == 0);
+    assert(restored.pc == 5 && restored.sp == 0 && restored.stack[0] == VAL_OBJ(pair));
+    assert(restored.memory[7] == 99);
+    assert(restored.free_ptr == vm.free_ptr && restored.allocated_list == vm.allocated_list);
+    assert(restored.heap[pair - MEM_SIZE] == 11 && restored.heap[pair - MEM_SIZE + 1] == 22);
+
+    // Copy-on-write: writes to a restored heap never reach the file
+    restored.heap[pair - MEM_SIZE] = 33;
+    VM again; reset_vm(&again);
+    again.code = code; again.code_size = sizeof(code);
+    assert(vm_snapshot_restore(&again, path) == 0);
+    assert(again.heap[pair - MEM_SIZE] == 11);
+
+    // A snapshot only restores into the program it was taken from
+    VM wrong; reset_vm(&wrong);
+    wrong.code = other; wrong.code_size = sizeof(other);
+    assert(vm_snapshot_restore(&wrong, path) != 0);
+    assert(wrong.heap == wrong.heap_storage);
+
+    vm_release_snapshot(&restored);
+    vm_release_snapshot(&again);
+    remove(path);
+    printf("  Result: state restored, heap mapped copy-on-write.\n");
+}
+
+// Overwrite one heap word of a snapshot file
+static void corrupt_snapshot_word(const char *path, int32_t idx, int32_t val) {
+    int fd = open(path, O_WRONLY);
+    assert(fd >= 0);
+    assert(pwrite(fd, &val, sizeof(val), SNAPSHOT_HEAP_OFFSET + idx * sizeof(int32_t)) == sizeof(val));
+    close(fd);
+}
+
+// A damaged object list is rejected instead of being followed by the collector
+void test_snapshot_rejects_corrupt_heap() {
+    printf("\n=== Test: Snapshot Rejects Corrupt Heap ===\n");
+    uint8_t code[] = { PUSH, 1, 0, 0, 0, HALT };
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/vm_snapshot_corrupt_%d.snap", (int)getpid());
+
+    VM vm; reset_vm(&vm);
+    vm.code = code; vm.code_size = sizeof(code);
+    Obj a = new_pair(1, 2);
+    Obj b = new_pair(3, 4);
+    int32_t a_hdr = (int32_t)a - MEM_SIZE - 3, b_hdr = (int32_t)b - MEM_SIZE - 3;
+    struct { int32_t idx, val; } damage[] = {
+        { b_hdr + 1, b_hdr },     // b -> b: a cycle
+        { b_hdr + 1, b_hdr + 2 }, // b -> into b's own header
+        { a_hdr, 1000 },          // a's size runs past free_ptr
+        { a_hdr, -1 },            // negative size
+        { b_hdr + 2, 1 },         // mark bit left set
+    };
+
+    for (int i = 0; i < (int)(sizeof(damage) / sizeof(damage[0])); i++) {
+        assert(vm_snapshot_write(&vm, path) == 0);
+        corrupt_snapshot_word(path, damage[i].idx, damage[i].val);
+        VM restored; reset_vm(&restored);
+        restored.code = code; restored.code_size = sizeof(code);
+        assert(vm_snapshot_restore(&restored, path) != 0);
+        assert(restored.heap == restored.heap_storage);
+    }
+
+    // Truncated: the heap pages are missing from the file
+    assert(vm_snapshot_write(&vm, path) == 0);
+    assert(truncate(path, SNAPSHOT_HEAP_OFFSET + 64) == 0);
+    VM restored; reset_vm(&restored);
+    restored.code = code; restored.code_size = sizeof(code);
+    assert(vm_snapshot_restore(&restored, path) != 0);
+
+    remove(path);
+    printf("  Result: all damaged snapshots rejected.\n");
+}
+
+// F sizes its frame with an ENTER that is not its first instruction
+static uint8_t misplaced_enter_program[] = {
+    CALL, 6, 0, 0, 0,
+    HALT,
+    PUSH, 1, 0, 0, 0,   // pc 6: F
+    ENTER, 1, 0, 0, 0,
+    RET,
+};
+
+void test_misplaced_enter_rejected() {
+    printf("\n=== Test: Misplaced ENTER ===\n");
+    VM vm; reset_vm(&vm);
+    vm.code = misplaced_enter_program; vm.code_size = sizeof(misplaced_enter_program);
+    assert(run_vm(&vm) == VM_ERROR);
+    assert(vm.pc == 16 && vm.rsp == 0);
+
+    // The JIT compiles it, but traps at the same instruction
+    jit_func fn = vm_compile(&vm);
+    assert(fn);
+    int result;
+    assert(vm_run_jit(&vm, fn, &result) == -1 && vm.error);
+    printf("  Result: both engines stopped at the ENTER.\n");
+}
+
+// Counts 5 down to 0 (4 taken back-edges), then adds one INPUT value
+static uint8_t fuel_program[] = {
+    PUSH, 5, 0, 0, 0,
+    PUSH, 1, 0, 0, 0,   // pc 5: loop
+    SUB, DUP,
+    JNZ, 5, 0, 0, 0,
+    INPUT,              // pc 17
+    ADD, HALT,
+};
+
+void test_fuel_yield_and_resume() {
+    printf("\n=== Test: Fuel Yield and Resume ===\n");
+    VM vm; reset_vm(&vm);
+    vm.code = fuel_program; vm.code_size = sizeof(fuel_program);
+    Inbox inbox = { 0 };
+    vm.inbox = &inbox;
+
+    vm.fuel = 3;
+    assert(run_vm(&vm) == VM_YIELDED);
+    assert(vm.pc == 5 && vm.stack[vm.sp] == 2);
+    vm.fuel = 100;
+    assert(vm_execute(&vm) == VM_BLOCKED);  // Empty inbox: INPUT waits and retries
+    assert(vm.pc == 17);
+    assert(inbox_put(&inbox, 42) == 0);
+    assert(vm_execute(&vm) == VM_HALTED);
+    assert(vm.sp == 0 && vm.stack[0] == 42);
+    free(inbox.values);
+    printf("  Result: yielded at the back-edge, blocked on INPUT, finished with 42.\n");
+}
+
+void test_scheduler_round_robin() {
+    printf("\n=== Test: Scheduler Round Robin ===\n");
+    VM vm; reset_vm(&vm);
+    vm.code = fuel_program; vm.code_size = sizeof(fuel_program);
+    jit_func fns[2] = { NULL, vm_compile(&vm) };
+    assert(fns[1]);
+
+    for (int m = 0; m < 2; m++) {
+        Scheduler s;
+        sched_init(&s, SCHED_ROUND_ROBIN, 1);
+        Task *tasks[3];
+        for (int i = 0; i < 3; i++) {
+            tasks[i] = sched_spawn(&s, fuel_program, sizeof(fuel_program), fns[m], 0);
+            assert(tasks[i]);
+        }
+        assert(sched_run(&s) == 3);
+        for (int i = 0; i < 3; i++) assert(sched_send(&s, tasks[i], 10 * i) == 0);
+        assert(sched_run(&s) == 0);
+        for (int i = 0; i < 3; i++) {
+            assert(tasks[i]->status == VM_HALTED && tasks[i]->result == 10 * i);
+            // A slice per taken back-edge, the blocked INPUT and the rest, in both engines
+            assert(tasks[i]->slices == 6u);
+        }
+        assert(s.slices == 18u);
+        sched_free(&s);
+        printf("  Result: %s tasks interleaved and woke on sched_send().\n", m ? "JIT" : "Interpreted");
+    }
+}
+
+// Two bulk operations on 1024 elements, 16 units of fuel each
+static uint8_t bulk_fuel_program[] = {
+    PUSH, 0, 4, 0, 0,   // 1024
+    ALLOC, DUP,
+    PUSH, 7, 0, 0, 0,
+    AFILL,
+    ASUM,
+    HALT,
+};
+
+void test_bulk_ops_charge_fuel() {
+    printf("\n=== Test: Bulk Operations Charge Fuel ===\n");
+    VM vm; reset_vm(&vm);
+    vm.code = bulk_fuel_program; vm.code_size = sizeof(bulk_fuel_program);
+    jit_func fns[2] = { NULL, vm_compile(&vm) };
+    assert(fns[1]);
+
+    for (int m = 0; m < 2; m++) {
+        Scheduler s;
+        sched_init(&s, SCHED_ROUND_ROBIN, 10);
+        Task *task = sched_spawn(&s, bulk_fuel_program, sizeof(bulk_fuel_program), fns[m], 0);
+        assert(task);
+        assert(sched_run(&s) == 0);
+        // Each operation uses up a 10-unit slice on its own
+        assert(task->status == VM_HALTED && task->result == 7 * 1024);
+        assert(task->slices == 3u);
+        sched_free(&s);
+        printf("  Result: %s bulk operations yielded by length.\n", m ? "JIT" : "Interpreted");
+    }
+}
+
+void test_scheduler_priority_order() {
+    printf("\n=== Test: Scheduler Priority Order ===\n");
+    Scheduler s;
+    sched_init(&s, SCHED_PRIORITY, 1);
+    int priorities[] = { 1, 5, 1, 9, 5 };
+    int expected[] = { 3, 1, 4, 0, 2 }; // Highest first, FIFO among equals
+    for (int i = 0; i < 5; i++) assert(sched_spawn(&s, fuel_program, sizeof(fuel_program), NULL, priorities[i]));
+    for (int i = 0; i < 5; i++) assert(sched_pop(&s)->id == expected[i]);
+    sched_free(&s);
+    printf("  Result: run queue ordered by priority.\n");
+}
 
 int main() {
     test_gc_basic_reachability();
@@ -228,6 +542,17 @@ int main() {
     test_gc_deep_object_graph();
     test_gc_closure_capture();
     test_gc_stress_allocation();
+    test_gc_telemetry_records();
+    test_gc_frame_locals_are_roots();
+    test_gc_interior_pointer_root();
+    test_simd_kernels_match_scalar();
+    test_snapshot_round_trip();
+    test_snapshot_rejects_corrupt_heap();
+    test_misplaced_enter_rejected();
+    test_fuel_yield_and_resume();
+    test_scheduler_round_robin();
+    test_bulk_ops_charge_fuel();
+    test_scheduler_priority_order();
     
     printf("\nAll Active Tests Passed.\n");
     return 0;
@@ -0,0 +1,35 @@
+; Test Indexed Memory Operations (LOADI/STOREI)
+; Expected Result: 42
+
+PUSH 2
+ALLOC         ; Allocate a 2-word object
+STORE 0       ; Keep its address at memory[0]
+
+PUSH 40
+LOAD 0
+STOREI        ; obj[0] = 40
+
+PUSH 2
+LOAD 0
+PUSH 1
+ADD
+STOREI        ; obj[1] = 2
+
+PUSH 7
+PUSH 5
+STOREI        ; memory[5] = 7 (data memory uses the same addresses)
+
+LOAD 0
+LOADI         ; obj[0]
+LOAD 0
+PUSH 1
+ADD
+LOADI         ; obj[1]
+ADD           ; 42
+
+PUSH 5
+LOADI
+SUB
+PUSH 7
+ADD           ; 42 - memory[5] + 7
+HALT
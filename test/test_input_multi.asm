@@ -0,0 +1,9 @@
+; Test INPUT with several values in one input stream
+; Input: "7 8\n  9" -> Expected Result: 24
+
+INPUT
+INPUT
+ADD
+INPUT
+ADD
+HALT
@@ -0,0 +1,13 @@
+; Test INPUT/PRINT in --binary-io mode (little-endian int32 in and out)
+; Input: 7, 8, -9 -> Output: 15, -135; Expected Result: -135
+
+INPUT
+INPUT
+ADD
+DUP
+PRINT
+INPUT
+MUL
+DUP
+PRINT
+HALT
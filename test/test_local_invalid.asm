@@ -0,0 +1,12 @@
+; Test Error: LOAD_LOCAL past the end of the frame
+; Expected: Runtime Error "Invalid Local"
+
+PUSH 7
+CALL F
+HALT
+
+F:
+    ENTER 1
+    STORE_LOCAL 0
+    LOAD_LOCAL 1    ; Only slot 0 exists
+    RET
@@ -0,0 +1,52 @@
+; Test frame locals: recursive binomial coefficient with two locals per frame,
+; plus an inlinable leaf with its own frame after the caller's
+; Expected Result: C(10, 4) + 5 * 5 = 235
+
+ENTER 1
+PUSH 5
+STORE_LOCAL 0   ; Must survive the calls below
+PUSH 10
+PUSH 4
+CALL BINOM      ; [210]
+LOAD_LOCAL 0
+CALL SQUARE     ; [210, 25]
+ADD
+HALT
+
+BINOM:
+    ; [n, k] -> [C(n, k)]
+    ENTER 2
+    STORE_LOCAL 1   ; k
+    STORE_LOCAL 0   ; n
+    LOAD_LOCAL 1
+    JZ ONE          ; C(n, 0) = 1
+    LOAD_LOCAL 0
+    LOAD_LOCAL 1
+    SUB
+    JZ ONE          ; C(n, n) = 1
+    LOAD_LOCAL 0
+    PUSH 1
+    SUB
+    LOAD_LOCAL 1
+    PUSH 1
+    SUB
+    CALL BINOM      ; [C(n-1, k-1)]
+    LOAD_LOCAL 0
+    PUSH 1
+    SUB
+    LOAD_LOCAL 1
+    CALL BINOM      ; [C(n-1, k-1), C(n-1, k)]
+    ADD
+    RET
+ONE:
+    PUSH 1
+    RET
+
+SQUARE:
+    ; [x] -> [x * x]
+    ENTER 1
+    STORE_LOCAL 0
+    LOAD_LOCAL 0
+    LOAD_LOCAL 0
+    MUL
+    RET
@@ -1,6 +1,8 @@
 import subprocess
 import os
 import re
+import json
+import struct
 
 # List of tests: (assembly_filename, expected_value, expected_error_substring, input_string)
 # If expected_error_substring is None, we expect success and check expected_value.
@@ -21,13 +23,21 @@ tests = [
     ("test_branching.asm", 1, None, None),
     ("test_memory.asm", 123, None, None),
     ("test_factorial.asm", 120, None, None),
+    ("test_indexed_memory.asm", 42, None, None),
+    ("test_array_ops.asm", 236, None, None),
+    ("test_locals.asm", 235, None, None),
+    ("test_call_fanout.asm", 6561, None, None),
     # Standard Library Input Test
     ("test_input.asm", 51, None, "50\n"),
+    ("test_input_multi.asm", 24, None, "7 8\n  9"),
     # Error Scenarios
     ("test_stack_underflow.asm", None, "Stack Underflow", None),
     ("test_stack_overflow.asm", None, "Stack Overflow", None),
     ("test_mem_oob.asm", None, "Heap Access Out of Bounds", None),
     ("test_div_zero.asm", None, "Division by Zero", None),
+    ("test_array_invalid.asm", None, "Invalid Array Address", None),
+    ("test_array_interior.asm", None, "Invalid Array Address", None),
+    ("test_local_invalid.asm", None, "Invalid Local", None),
 ]
 
 print(f"{'Test File':<25} | {'Expected':<15} | {'Actual':<25} | {'Status':<10}")
@@ -37,11 +47,12 @@ passed_count = 0
 failed_count = 0
 jit_passed_count = 0
 jit_failed_count = 0
-jit_skipped_count = 0
 
 # --- C Unit Tests ---
 print("Running C Unit Tests...")
 c_tests = ["test/test_gc_impl.c"]
+# Support modules linked into every C unit test (vm.c is #included by the test)
+c_test_deps = ["jit.c", "io.c", "profile.c", "symtab.c", "jit_perf.c", "simd.c", "aot.c"]
 c_passed = 0
 c_failed = 0
 
@@ -50,7 +61,7 @@ for c_test in c_tests:
     try:
         # Compile
         subprocess.check_call(
-            ["gcc", "-I.", c_test, "jit.c", "-o", exe_path],
+            ["gcc", "-I.", c_test, *c_test_deps, "-o", exe_path],
             stdout=subprocess.DEVNULL,
             stderr=subprocess.DEVNULL
         )
@@ -152,10 +163,10 @@ for test_file, expected_val, expected_err, input_str in tests:
                     jit_stdout = proc_jit.stdout
                     jit_stderr = proc_jit.stderr
                     
-                    # Check for JIT Compilation Failure (Unsupported Opcode)
+                    # The JIT compiles every opcode, so a compilation failure is a failure
                     if "JIT Compilation Failed" in jit_stderr or "JIT Error" in jit_stderr:
-                         print(f"  └── JIT: SKIP (Unsupported Opcodes)")
-                         jit_skipped_count += 1
+                        print(f"  └── JIT: FAIL (Compilation) Stderr: {jit_stderr.strip()[:40]}")
+                        jit_failed_count += 1
                     else:
                         jit_match = re.search(r"JIT Result: (-?\d+)", jit_stdout)
                         
@@ -190,11 +201,209 @@ for test_file, expected_val, expected_err, input_str in tests:
         print(f"{test_file:<25} | {'?':<15} | {str(e):<25} | FAIL")
         failed_count += 1
 
+# --- AOT Executables ---
+# Each program is compiled with --aot-exe and must print exactly what the interpreter does
+print("-" * 85)
+print("Running AOT Executable Tests...")
+aot_tests = ["test_call2.asm", "test_factorial.asm", "test_locals.asm", "test_call_fanout.asm"]
+aot_passed = 0
+aot_failed = 0
+
+for test_file in aot_tests:
+    asm_path = os.path.join("test", test_file)
+    bin_path = asm_path.replace(".asm", ".bin")
+    exe_path = asm_path.replace(".asm", ".aot")
+    try:
+        subprocess.check_call(
+            ["python3", "assembler.py", asm_path, bin_path],
+            stdout=subprocess.DEVNULL,
+            stderr=subprocess.DEVNULL
+        )
+        interp = subprocess.run(["./vm", bin_path], capture_output=True, text=True)
+        build = subprocess.run(["./vm", bin_path, f"--aot-exe={exe_path}"], capture_output=True, text=True)
+        if build.returncode != 0:
+            status = "FAIL (Build)"
+            actual = build.stderr.strip()[:25]
+            aot_failed += 1
+        else:
+            proc = subprocess.run([f"./{exe_path}"], capture_output=True, text=True)
+            match = re.search(r"Top of stack: (-?\d+)", proc.stdout)
+            actual = match.group(1) if match else "?"
+            if proc.returncode == interp.returncode and proc.stdout == interp.stdout:
+                status = "PASS"
+                aot_passed += 1
+            else:
+                status = "FAIL (Output)"
+                aot_failed += 1
+    except Exception as e:
+        status = "FAIL"
+        actual = str(e)[:25]
+        aot_failed += 1
+    finally:
+        for path in (bin_path, exe_path):
+            if os.path.exists(path):
+                os.remove(path)
+    print(f"{test_file:<25} | {'(Interpreter)':<15} | {actual:<25} | {status:<10}")
+
+# --- Tool Tests ---
+# Each check assembles its own program and returns (ok, detail)
+def remove_files(*paths):
+    for path in paths:
+        if os.path.exists(path):
+            os.remove(path)
+
+def check_profile():
+    # test_loop runs its body 5 times: LOOP is entered 6 times (27 instructions), END once
+    asm_path = os.path.join("test", "test_loop.asm")
+    bin_path = asm_path.replace(".asm", ".bin")
+    sym_path = asm_path.replace(".asm", ".sym")
+    json_path = asm_path.replace(".asm", ".profile.json")
+    snap_path = asm_path.replace(".asm", ".snap")
+    try:
+        subprocess.check_call(["python3", "assembler.py", asm_path, bin_path, "--sym"],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        # The second run plants a snapshot trap at LOOP, which must not change any count
+        for extra in ([], ["--snapshot-at=LOOP", f"--snapshot-file={snap_path}"]):
+            proc = subprocess.run(["./vm", bin_path, f"--profile={json_path}", *extra],
+                                  capture_output=True, text=True)
+            if proc.returncode != 0:
+                return False, f"Exit {proc.returncode}"
+            with open(json_path) as f:
+                prof = json.load(f)
+            labels = {row["label"]: row["count"] for row in prof["labels"]}
+            back_edges = {row["label"]: row["count"] for row in prof["back_edges"]}
+            if labels.get("LOOP") != 27 or labels.get("END") != 1 or back_edges != {"LOOP": 5}:
+                return False, f"labels {labels} back_edges {back_edges}"
+            if prof["total_instructions"] != 29:
+                return False, f"total {prof['total_instructions']}"
+        return True, "LOOP 27, back-edge 5"
+    finally:
+        remove_files(bin_path, sym_path, json_path, snap_path)
+
+def check_perf():
+    # The perf map must name the label regions and every jitdump record must parse
+    asm_path = os.path.join("test", "test_loop.asm")
+    bin_path = asm_path.replace(".asm", ".bin")
+    sym_path = asm_path.replace(".asm", ".sym")
+    map_path = dump_path = None
+    try:
+        subprocess.check_call(["python3", "assembler.py", asm_path, bin_path, "--sym"],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        proc = subprocess.Popen(["./vm", bin_path, "--jit", "--perf-map", "--jitdump"],
+                                stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        map_path = f"/tmp/perf-{proc.pid}.map"
+        dump_path = f"/tmp/jit-{proc.pid}.dump"
+        if proc.wait() != 0:
+            return False, f"Exit {proc.returncode}"
+
+        with open(map_path) as f:
+            names = [line.split()[2] for line in f if len(line.split()) == 3]
+        if "vm:LOOP" not in names:
+            return False, f"map {names}"
+
+        with open(dump_path, "rb") as f:
+            data = f.read()
+        magic, version, header_size, mach = struct.unpack_from("<IIII", data, 0)
+        if magic != 0x4A695444 or version != 1 or header_size != 40 or mach != 62:
+            return False, "bad jitdump header"
+        pos, loads, lines = header_size, [], []
+        while pos < len(data):
+            rec_id, rec_size = struct.unpack_from("<II", data, pos)
+            if rec_size < 16 or pos + rec_size > len(data):
+                return False, f"bad record size at {pos}"
+            if rec_id == 0:   # JIT_CODE_LOAD: fixed part, name, code
+                code_size = struct.unpack_from("<Q", data, pos + 40)[0]
+                name_end = data.index(b"\0", pos + 56)
+                if name_end + 1 + code_size != pos + rec_size:
+                    return False, "code load size mismatch"
+                loads.append(data[pos + 56:name_end].decode())
+            elif rec_id == 2: # JIT_CODE_DEBUG_INFO: fixed part, then (addr, line, discrim, file)
+                entry = pos + 32
+                for _ in range(struct.unpack_from("<Q", data, pos + 24)[0]):
+                    line = struct.unpack_from("<I", data, entry + 8)[0]
+                    file_end = data.index(b"\0", entry + 16)
+                    lines.append((data[entry + 16:file_end].decode(), line))
+                    entry = file_end + 1
+                if entry != pos + rec_size:
+                    return False, "debug info size mismatch"
+            pos += rec_size
+        if sorted(loads) != sorted(names):
+            return False, f"loads {loads}"
+        # Line numbers refer to the .asm: LOOP's DUP is on line 7 of test_loop.asm
+        if not lines or any(file != asm_path for file, _ in lines) or (asm_path, 7) not in lines:
+            return False, f"lines {lines[:3]}"
+        return True, f"{len(loads)} loads, {len(lines)} lines"
+    finally:
+        remove_files(bin_path, sym_path, *(p for p in (map_path, dump_path) if p))
+
+def check_binary_io():
+    # Raw int32 input from a regular file (mmapped) and from a pipe (read), under both engines
+    asm_path = os.path.join("test", "test_io_binary.asm")
+    bin_path = asm_path.replace(".asm", ".bin")
+    in_path = asm_path.replace(".asm", ".in")
+    try:
+        subprocess.check_call(["python3", "assembler.py", asm_path, bin_path],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        data = struct.pack("<3i", 7, 8, -9)
+        expected = struct.pack("<2i", 15, -135)
+        with open(in_path, "wb") as f:
+            f.write(data)
+        for engine in ([], ["--jit"]):
+            with open(in_path, "rb") as f:
+                from_file = subprocess.run(["./vm", bin_path, "--binary-io", *engine],
+                                           stdin=f, capture_output=True)
+            from_pipe = subprocess.run(["./vm", bin_path, "--binary-io", *engine],
+                                       input=data, capture_output=True)
+            for proc in (from_file, from_pipe):
+                # Results go to stderr so they never mix with the binary stream
+                if proc.returncode != 0 or proc.stdout != expected or b"-135" not in proc.stderr:
+                    return False, f"{' '.join(engine) or 'interp'}: {proc.stdout.hex()}"
+        return True, "file + pipe, interp + JIT"
+    finally:
+        remove_files(bin_path, in_path)
+
+def check_assembler_enter():
+    # ENTER anywhere but a function entry is an assembly error
+    asm_path = os.path.join("test", "test_enter_misplaced.asm")
+    bin_path = asm_path.replace(".asm", ".bin")
+    try:
+        proc = subprocess.run(["python3", "assembler.py", asm_path, bin_path],
+                              capture_output=True, text=True)
+        if proc.returncode == 0 or "ENTER must be the first" not in proc.stderr:
+            return False, f"Exit {proc.returncode}"
+        return True, "rejected"
+    finally:
+        remove_files(bin_path)
+
+print("-" * 85)
+print("Running Tool Tests...")
+tool_tests = [
+    ("--profile", check_profile),
+    ("--perf-map / --jitdump", check_perf),
+    ("--binary-io", check_binary_io),
+    ("assembler ENTER check", check_assembler_enter),
+]
+tool_passed = 0
+tool_failed = 0
+
+for name, check in tool_tests:
+    try:
+        ok, actual = check()
+    except Exception as e:
+        ok, actual = False, str(e)
+    if ok:
+        tool_passed += 1
+    else:
+        tool_failed += 1
+    print(f"{name:<25} | {'(Tool)':<15} | {actual[:25]:<25} | {'PASS' if ok else 'FAIL':<10}")
+
 # Summary
 total_interp = passed_count + failed_count
-total_jit = jit_passed_count + jit_failed_count + jit_skipped_count
+total_jit = jit_passed_count + jit_failed_count
 total_c = c_passed + c_failed
-total_all = total_interp + total_jit + total_c
+total_aot = aot_passed + aot_failed
+total_tool = tool_passed + tool_failed
+total_all = total_interp + total_jit + total_c + total_aot + total_tool
 
 pass_all = passed_count + jit_passed_count
 perc = (pass_all / (total_interp + jit_passed_count + jit_failed_count) * 100) if (total_interp + jit_passed_count + jit_failed_count) > 0 else 0
@@ -203,11 +412,13 @@ output_lines = []
 output_lines.append("-" * 85)
 output_lines.append(f"C Units:     {c_passed}/{total_c} passed")
 output_lines.append(f"Interpreter: {passed_count}/{total_interp} passed")
-output_lines.append(f"JIT:         {jit_passed_count}/{total_jit} passed ({jit_skipped_count} skipped)")
-output_lines.append(f"Total:       {pass_all + c_passed}/{total_all} passed ({perc:.1f}%)")
+output_lines.append(f"JIT:         {jit_passed_count}/{total_jit} passed")
+output_lines.append(f"AOT:         {aot_passed}/{total_aot} passed")
+output_lines.append(f"Tools:       {tool_passed}/{total_tool} passed")
+output_lines.append(f"Total:       {pass_all + c_passed + aot_passed + tool_passed}/{total_all} passed ({perc:.1f}%)")
 
-if failed_count > 0 or jit_failed_count > 0 or c_failed > 0:
-    output_lines.append(f"Failures: {c_failed} C, {failed_count} Interp, {jit_failed_count} JIT")
+if failed_count > 0 or jit_failed_count > 0 or c_failed > 0 or aot_failed > 0 or tool_failed > 0:
+    output_lines.append(f"Failures: {c_failed} C, {failed_count} Interp, {jit_failed_count} JIT, {aot_failed} AOT, {tool_failed} Tool")
 else:
     output_lines.append("All tests passed!")
 
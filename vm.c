@@ -4,11 +4,23 @@
 #include <string.h>
 #include "opcodes.h"
 #include "jit.h"
+#include "io.h"
+#include "profile.h"
+#include "symtab.h"
+#include "simd.h"
+#include "aot.h"
 #include <time.h>
+#include <setjmp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define STACK_SIZE 256
 #define MEM_SIZE 1024
 #define HEAP_SIZE 65536
+#define LOCALS_SIZE 1024   // Frame-local slots shared by all active frames
+#define BULK_FUEL_ELEMENTS 64 // Elements a bulk array opcode processes per unit of fuel
 
 typedef struct {
     int32_t size;      // Payload size in words
@@ -16,16 +28,67 @@ typedef struct {
     uint8_t marked;    // Garbage Collection accessibility flag (0 = Unmarked, 1 = Marked)
 } ObjectHeader;
 
+// Telemetry for one collection (see vm_gc_record / --gc-log)
+typedef struct {
+    int cycle;               // 1-based collection number
+    double start;            // Seconds since run start (monotonic clock)
+    double pause;            // Total stop-the-world time in seconds
+    double mark_time;
+    double sweep_time;
+    int heap_words_before;   // Heap words (headers included) held by all objects, garbage included
+    int live_words_after;    // Heap words held by the objects that survived
+    int objects_marked;
+    int objects_freed;
+    int64_t words_allocated; // Allocated since the previous collection
+    double alloc_rate;       // words_allocated per second of mutator time since the previous collection
+} GCRecord;
+
+// Pause-time distribution over all recorded collections (seconds)
+typedef struct {
+    int count;
+    double p50;
+    double p99;
+    double max;
+    double total;
+} GCPauseSummary;
+
+// Why vm_execute() returned
+typedef enum {
+    VM_HALTED,   // HALT, or ran off the end of the code
+    VM_ERROR,    // Runtime error (already reported)
+    VM_YIELDED,  // Out of fuel; vm_execute() resumes where it stopped
+    VM_BLOCKED,  // INPUT with an empty inbox; resumes at the INPUT
+} VMStatus;
+
+#define VM_FUEL_UNLIMITED INT64_MAX
+
+// Values queued for INPUT by the scheduler (see sched_send)
+typedef struct {
+    int32_t *values;
+    int head;
+    int count;
+    int cap;
+} Inbox;
+
+struct Task;
+
 typedef struct {
     int32_t stack[STACK_SIZE];
     int sp;                // Data Stack Pointer
     int32_t memory[MEM_SIZE];
-    int32_t heap[HEAP_SIZE];
+    int32_t *heap;         // heap_storage, or a copy-on-write mapping of a snapshot
+    int32_t heap_storage[HEAP_SIZE];
     int32_t free_ptr;      // Heap allocation pointer (Bump Pointer)
     int32_t allocated_list; // Linked list head of allocated objects
+    uint32_t heap_starts[HEAP_SIZE / 32]; // One bit per heap word, set where a live object's header starts
     uint32_t return_stack[STACK_SIZE];
     int rsp;               // Return Stack Pointer
+    int32_t locals[LOCALS_SIZE]; // Frame-local slots (LOAD_LOCAL / STORE_LOCAL)
+    int fp;                // Frame Pointer: first slot of the current frame
+    int frame_top;         // End of the current frame, where a CALL starts the next one
+    int32_t frame_stack[STACK_SIZE]; // Caller's fp for each return stack entry
     uint8_t *code;         // Bytecode array
+    int code_size;         // Bytecode length in bytes
     int pc;                // Program Counter
     int running;
     int error;             // Error flag
@@ -34,10 +97,86 @@ typedef struct {
     int stats_freed_objects;
     double stats_total_gc_time;
     int stats_max_heap_used;
+    // GC Telemetry
+    GCRecord *gc_records;  // One record per collection (grown on demand)
+    int gc_record_count;
+    int gc_record_cap;
+    FILE *gc_log;          // JSON Lines log, one object per collection (NULL = off)
+    double gc_epoch;       // Monotonic time at run start
+    double gc_last_end;    // Monotonic time the previous collection finished
+    int64_t gc_words_allocated; // Words allocated since the previous collection
+    int gc_marked;         // Objects marked in the current cycle
+    int gc_heap_before;    // Scratch for the current cycle, filled by sweep()
+    int gc_live_after;
+    int gc_stress;         // Collect before every allocation (testing / benchmarking)
+    // JIT State
+    jmp_buf jit_trap;      // Runtime errors inside JIT code unwind here (see vm_run_jit)
+    int64_t *jit_stack_lo; // Live native operand stack of JIT code, scanned as GC roots
+    int64_t *jit_stack_hi;
+    Profile *profile;      // Execution profile (NULL unless --profile)
+    // Snapshot State
+    int snapshot_pc;       // Write a snapshot when execution reaches this pc (-1 = off)
+    uint8_t snapshot_opcode; // Original opcode replaced by the SNAPSHOT_TRAP
+    const char *snapshot_path;
+    void *snapshot_map;    // Restored heap mapping (NULL when heap == heap_storage)
+    // Scheduling
+    int64_t fuel;          // Back-edges and CALLs left before yielding; set by the host
+    int suspended;         // VM_YIELDED / VM_BLOCKED when execution stopped without HALT
+    Inbox *inbox;          // INPUT source when scheduled (NULL = stdin)
+    struct Task *task;     // Scheduler task running this VM's JIT code (NULL otherwise)
 } VM;
 
+// Set the non-zero defaults of an all-zero VM
+static void vm_init_zeroed(VM *vm) {
+    vm->heap = vm->heap_storage;
+    vm->sp = -1;
+    vm->rsp = -1;
+    vm->allocated_list = -1;
+    vm->snapshot_pc = -1;
+    vm->fuel = VM_FUEL_UNLIMITED;
+}
+
+// Zero a VM and point it at its own heap. Every VM must be initialized this way.
+void vm_init(VM *vm) {
+    memset(vm, 0, sizeof(VM));
+    vm_init_zeroed(vm);
+}
+
+// Heap-allocate an initialized VM. The memory comes from calloc, so pages the
+// program never touches (most of the heap, for small programs) stay unmapped.
+VM *vm_create(void) {
+    VM *vm = calloc(1, sizeof(VM));
+    if (vm) vm_init_zeroed(vm);
+    return vm;
+}
+
+static int inbox_take(Inbox *in, int32_t *out) {
+    if (in->count == 0) return 0;
+    *out = in->values[in->head];
+    in->head = (in->head + 1) % in->cap;
+    in->count--;
+    return 1;
+}
+
+static int inbox_put(Inbox *in, int32_t val) {
+    if (in->count == in->cap) {
+        int cap = in->cap ? in->cap * 2 : 16;
+        int32_t *values = malloc(cap * sizeof(int32_t));
+        if (!values) return -1;
+        for (int i = 0; i < in->count; i++) values[i] = in->values[(in->head + i) % in->cap];
+        free(in->values);
+        in->values = values;
+        in->head = 0;
+        in->cap = cap;
+    }
+    in->values[(in->head + in->count) % in->cap] = val;
+    in->count++;
+    return 0;
+}
+
 // Helper to handle runtime errors safely
 void error(VM *vm, const char *msg) {
+    io_flush(); // Keep program output ordered before the diagnostic
     fprintf(stderr, "Runtime Error: %s\n", msg);
     vm->running = 0;
     vm->error = 1;
@@ -45,19 +184,34 @@ void error(VM *vm, const char *msg) {
 
 
 
+// Object-start bitmap: conservative roots and array operands may be any integer, so only
+// addresses that vm_alloc() handed out (and sweep() has not freed) are treated as objects
+static inline void heap_set_start(VM *vm, int32_t idx) {
+    vm->heap_starts[idx >> 5] |= 1u << (idx & 31);
+}
+
+static inline void heap_clear_start(VM *vm, int32_t idx) {
+    vm->heap_starts[idx >> 5] &= ~(1u << (idx & 31));
+}
+
+static inline int heap_is_object(const VM *vm, int64_t idx) {
+    if (idx < 0 || idx >= vm->free_ptr) return 0;
+    return (vm->heap_starts[idx >> 5] >> (idx & 31)) & 1;
+}
+
 void mark(VM *vm, int32_t addr) {
-    if (addr < 0 || addr >= HEAP_SIZE) return; // Invalid address
-    
-    // Address Validation: ensure we are within heap bounds.
-    int32_t obj_idx = addr; 
-    
+    // Conservative roots may be plain integers or point into the middle of an object
+    if (!heap_is_object(vm, addr)) return;
+    int32_t obj_idx = addr;
+    int32_t size = vm->heap[obj_idx]; // Header[0] is size
+
     // Check mark bit in object header (offset +2 from base address).
     if (vm->heap[obj_idx + 2]) return; 
     
     vm->heap[obj_idx + 2] = 1; // Set mark bit.
+    vm->gc_marked++;
 
     // Recursive Marking (Transitive Reachability)
-    int32_t size = vm->heap[obj_idx]; // Header[0] is size
     int32_t payload_idx = obj_idx + 3; // Skip 3-word header
     
     for (int i = 0; i < size; i++) {
@@ -76,20 +230,26 @@ void mark(VM *vm, int32_t addr) {
 void sweep(VM *vm) {
     int32_t *curr_ptr = &vm->allocated_list; // Pointer to the 'next' field of previous node (or head)
     int32_t curr = vm->allocated_list;
+    vm->gc_heap_before = 0;
+    vm->gc_live_after = 0;
 
     while (curr != -1) {
         // curr is index of Header[0] (Size)
         // Header[2] is Mark
         int marked = vm->heap[curr + 2];
         int next = vm->heap[curr + 1];
+        int words = vm->heap[curr] + 3; // Payload + header
 
+        vm->gc_heap_before += words;
         if (marked) {
+            vm->gc_live_after += words;
             vm->heap[curr + 2] = 0; // Unmark for next cycle
             curr_ptr = &vm->heap[curr + 1]; // Advance ptr-to-next to this node's next field
             curr = next;
         } else {
             // Unlink
             *curr_ptr = next; // Previous node now points to next
+            heap_clear_start(vm, curr);
             // Essentially "freeing" logic (logical collection)
             vm->stats_freed_objects++;
             curr = next;
@@ -102,27 +262,136 @@ void sweep(VM *vm) {
     }
 }
 
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void gc_log_record(FILE *f, const GCRecord *r) {
+    fprintf(f, "{\"cycle\": %d, \"t\": %.6f, \"pause_us\": %.3f, \"mark_us\": %.3f, \"sweep_us\": %.3f, "
+               "\"heap_words_before\": %d, \"live_words_after\": %d, \"marked\": %d, \"freed\": %d, "
+               "\"alloc_words\": %lld, \"alloc_rate_wps\": %.0f}\n",
+            r->cycle, r->start, r->pause * 1e6, r->mark_time * 1e6, r->sweep_time * 1e6,
+            r->heap_words_before, r->live_words_after, r->objects_marked, r->objects_freed,
+            (long long)r->words_allocated, r->alloc_rate);
+}
+
+static void gc_store_record(VM *vm, const GCRecord *r) {
+    if (vm->gc_record_count == vm->gc_record_cap) {
+        int cap = vm->gc_record_cap ? vm->gc_record_cap * 2 : 64;
+        GCRecord *grown = realloc(vm->gc_records, cap * sizeof(GCRecord));
+        if (!grown) return; // Keep collecting; only the history is lost
+        vm->gc_records = grown;
+        vm->gc_record_cap = cap;
+    }
+    vm->gc_records[vm->gc_record_count++] = *r;
+}
+
+// Conservative root check: any value inside the heap address range may be a pointer
+static void mark_root(VM *vm, int64_t val) {
+    if (val >= MEM_SIZE && val < MEM_SIZE + HEAP_SIZE) {
+        // Potential Heap Pointer
+        int32_t payload_idx = (int32_t)val - MEM_SIZE;
+        int32_t header_idx = payload_idx - 3;
+        if (header_idx >= 0) { // Basic sanity check
+            mark(vm, header_idx);
+        }
+    }
+}
+
 void vm_gc(VM *vm) {
-    clock_t start = clock();
+    double start = monotonic_seconds();
+    int freed_before = vm->stats_freed_objects;
     vm->stats_gc_runs++;
-    // 1. Mark Phase: Scan Stack
+    vm->gc_marked = 0;
+
+    // 1. Mark Phase: Scan Stack and the locals of every active frame
     for (int i = 0; i <= vm->sp; i++) {
-        int32_t val = vm->stack[i];
-        if (val >= MEM_SIZE && val < MEM_SIZE + HEAP_SIZE) {
-            // Potential Heap Pointer
-            int32_t payload_idx = val - MEM_SIZE;
-            int32_t header_idx = payload_idx - 3;
-            if (header_idx >= 0) { // Basic sanity check
-                mark(vm, header_idx);
-            }
-        }
+        mark_root(vm, vm->stack[i]);
     }
+    for (int i = 0; i < vm->frame_top; i++) {
+        mark_root(vm, vm->locals[i]);
+    }
+    // JIT code keeps its operands and locals on the native stack as 64-bit slots
+    for (int64_t *slot = vm->jit_stack_lo; slot && slot < vm->jit_stack_hi; slot++) {
+        mark_root(vm, *slot);
+    }
+    double mark_end = monotonic_seconds();
 
     // 2. Sweep Phase
     sweep(vm);
     
-    clock_t end = clock();
-    vm->stats_total_gc_time += (double)(end - start) / CLOCKS_PER_SEC;
+    double end = monotonic_seconds();
+    vm->stats_total_gc_time += end - start;
+
+    // 3. Telemetry
+    // The first cycle measures mutator time from the start of the run
+    if (vm->gc_epoch == 0) vm->gc_epoch = start; // Collector driven directly (unit tests)
+    double since = vm->gc_last_end > 0 ? vm->gc_last_end : vm->gc_epoch;
+    double mutator_time = start - since;
+    GCRecord r = {
+        .cycle = vm->stats_gc_runs,
+        .start = start - vm->gc_epoch,
+        .pause = end - start,
+        .mark_time = mark_end - start,
+        .sweep_time = end - mark_end,
+        .heap_words_before = vm->gc_heap_before,
+        .live_words_after = vm->gc_live_after,
+        .objects_marked = vm->gc_marked,
+        .objects_freed = vm->stats_freed_objects - freed_before,
+        .words_allocated = vm->gc_words_allocated,
+        .alloc_rate = mutator_time > 0 ? (double)vm->gc_words_allocated / mutator_time : 0.0,
+    };
+    gc_store_record(vm, &r);
+    if (vm->gc_log) gc_log_record(vm->gc_log, &r);
+
+    vm->gc_words_allocated = 0;
+    vm->gc_last_end = end;
+}
+
+// --- GC Telemetry Query API ---
+
+int vm_gc_record_count(const VM *vm) {
+    return vm->gc_record_count;
+}
+
+const GCRecord *vm_gc_record(const VM *vm, int i) {
+    if (i < 0 || i >= vm->gc_record_count) return NULL;
+    return &vm->gc_records[i];
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile over sorted values
+static double percentile(const double *sorted, int n, double p) {
+    int rank = (int)(p * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+void vm_gc_pause_summary(const VM *vm, GCPauseSummary *out) {
+    memset(out, 0, sizeof(*out));
+    int n = vm->gc_record_count;
+    if (n == 0) return;
+
+    double *pauses = malloc(n * sizeof(double));
+    if (!pauses) return;
+    for (int i = 0; i < n; i++) {
+        pauses[i] = vm->gc_records[i].pause;
+        out->total += pauses[i];
+    }
+    qsort(pauses, n, sizeof(double), cmp_double);
+
+    out->count = n;
+    out->p50 = percentile(pauses, n, 0.50);
+    out->p99 = percentile(pauses, n, 0.99);
+    out->max = pauses[n - 1];
+    free(pauses);
 }
 
 void push(VM *vm, int32_t val) {
@@ -141,32 +410,312 @@ int32_t pop(VM *vm) {
     return vm->stack[vm->sp--];
 }
 
-void run_vm(VM *vm) {
-    vm->pc = 0;
-    vm->sp = -1;
-    vm->rsp = -1;
-    vm->running = 1;
-    vm->pc = 0;
-    vm->sp = -1;
-    vm->rsp = -1;
-    vm->running = 1;
-    vm->pc = 0;
-    vm->sp = -1;
-    vm->rsp = -1;
-    vm->running = 1;
-    vm->error = 0;
-    vm->free_ptr = 0; // Initialize heap pointer to start
-    vm->allocated_list = -1; // -1 denotes end of linked list
-    vm->stats_gc_runs = 0;
-    vm->stats_freed_objects = 0;
-    vm->stats_total_gc_time = 0.0;
-    vm->stats_max_heap_used = 0;
+// Resolve a unified address (Memory 0-1023, Heap 1024+) to its storage slot
+static int32_t *memory_slot(VM *vm, int32_t idx) {
+    if (idx < 0) {
+        error(vm, "Memory Access Out of Bounds");
+        return NULL;
+    }
+    if (idx < MEM_SIZE) return &vm->memory[idx];
+    if (idx - MEM_SIZE >= HEAP_SIZE) {
+        error(vm, "Heap Access Out of Bounds");
+        return NULL;
+    }
+    return &vm->heap[idx - MEM_SIZE];
+}
+
+// Allocate 'size' payload words, collecting if the heap is full. Returns the payload address.
+static int32_t vm_alloc(VM *vm, int32_t size) {
+    if (size < 0) { error(vm, "Invalid Allocation Size"); return 0; }
+    
+    // Header: 3 words [Size, Next, Marked]
+    int needed = size + 3; 
+    if (vm->free_ptr + needed > HEAP_SIZE || vm->gc_stress) {
+        vm_gc(vm); // Trigger Garbage Collection
+        if (vm->free_ptr + needed > HEAP_SIZE) { // Retry Allocation
+            error(vm, "Heap Overflow");
+            return 0;
+        }
+    }
 
+    int32_t addr = vm->free_ptr;
+    vm->heap[addr] = size;                     // Header[0]: Size
+    vm->heap[addr + 1] = vm->allocated_list;   // Header[1]: Next Object
+    vm->heap[addr + 2] = 0;                    // Header[2]: Mark Bit
+    
+    vm->allocated_list = addr;                 // Update List Head
+    heap_set_start(vm, addr);
+    vm->free_ptr += needed;                    // Advance Pointer
+    vm->gc_words_allocated += needed;
+    
+    if (vm->free_ptr > vm->stats_max_heap_used) {
+        vm->stats_max_heap_used = vm->free_ptr;
+    }
+    
+    // Address of payload (skip header)
+    return MEM_SIZE + addr + 3;
+}
+
+// Resolve an object address returned by ALLOC to its payload and length.
+// Reports an error and returns NULL if it does not name an allocated object.
+static int32_t *heap_array(VM *vm, int32_t addr, int32_t *len) {
+    int64_t header = (int64_t)addr - MEM_SIZE - 3;
+    if (!heap_is_object(vm, header)) { // Interior pointers would let kernels cross objects
+        error(vm, "Invalid Array Address");
+        return NULL;
+    }
+    *len = vm->heap[header];
+    return &vm->heap[header + 3];
+}
+
+// Bulk array opcodes (AFILL..AMUL). 'b' is the value or source operand of binary
+// forms. Returns the reduction result for ASUM/AMIN/AMAX, and in *fuel the units
+// the operation costs (one per BULK_FUEL_ELEMENTS elements).
+static int32_t bulk_op(VM *vm, uint8_t op, int32_t a, int32_t b, int32_t *fuel) {
+    const SimdKernels *k = simd_kernels();
+    int32_t len, src_len;
+    int32_t *dst = heap_array(vm, a, &len);
+    *fuel = 0;
+    if (!dst) return 0;
+
+    *fuel = len / BULK_FUEL_ELEMENTS;
+    switch (op) {
+    case AFILL:
+        k->fill(dst, b, len);
+        return 0;
+    case ASUM:
+        return k->sum(dst, len);
+    case AMIN:
+    case AMAX:
+        if (len == 0) { error(vm, "Empty Array"); return 0; }
+        return (op == AMIN) ? k->min(dst, len) : k->max(dst, len);
+    default: {
+        int32_t *src = heap_array(vm, b, &src_len);
+        if (!src) return 0;
+        int n = (len < src_len) ? len : src_len;
+        *fuel = n / BULK_FUEL_ELEMENTS;
+        if (op == ACOPY) k->copy(dst, src, n);
+        else if (op == AADD) k->add(dst, src, n);
+        else k->mul(dst, src, n);
+        return 0;
+    }
+    }
+}
+
+// --- Snapshots ---
+// A snapshot holds everything needed to resume: registers, both stacks and data
+// memory in the header, then the whole heap at a page-aligned offset so a restore
+// can map it copy-on-write. Unchanged heap pages stay shared with the page cache,
+// and so with every other process restored from the same file.
+
+#define SNAPSHOT_MAGIC "VMSNAP1"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_HEAP_OFFSET 65536 // Multiple of any page size we run on (4K-64K)
+#define SNAPSHOT_TRAP 0xFE         // Planted at snapshot_pc; never produced by the assembler
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t heap_offset;
+    uint32_t heap_words;
+    int32_t code_size;
+    uint64_t code_hash;   // Restores are refused for a different program
+    int32_t pc;
+    int32_t sp;
+    int32_t rsp;
+    int32_t free_ptr;
+    int32_t allocated_list;
+    int32_t fp;
+    int32_t frame_top;
+    int32_t stack[STACK_SIZE];
+    uint32_t return_stack[STACK_SIZE];
+    int32_t frame_stack[STACK_SIZE];
+    int32_t locals[LOCALS_SIZE];
+    int32_t memory[MEM_SIZE];
+} SnapshotHeader;
+
+// FNV-1a
+static uint64_t code_hash(const uint8_t *code, int size) {
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; i < size; i++) {
+        h ^= code[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Returns 0 on success, -1 (with a message on stderr) on failure
+int vm_snapshot_write(VM *vm, const char *path) {
+    SnapshotHeader *h = calloc(1, sizeof(SnapshotHeader));
+    if (!h) {
+        fprintf(stderr, "Snapshot Error: Memory allocation failed\n");
+        return -1;
+    }
+    memcpy(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic));
+    h->version = SNAPSHOT_VERSION;
+    h->heap_offset = SNAPSHOT_HEAP_OFFSET;
+    h->heap_words = HEAP_SIZE;
+    h->code_size = vm->code_size;
+    h->code_hash = code_hash(vm->code, vm->code_size);
+    h->pc = vm->pc;
+    h->sp = vm->sp;
+    h->rsp = vm->rsp;
+    h->free_ptr = vm->free_ptr;
+    h->allocated_list = vm->allocated_list;
+    h->fp = vm->fp;
+    h->frame_top = vm->frame_top;
+    memcpy(h->stack, vm->stack, sizeof(h->stack));
+    memcpy(h->return_stack, vm->return_stack, sizeof(h->return_stack));
+    memcpy(h->frame_stack, vm->frame_stack, sizeof(h->frame_stack));
+    memcpy(h->locals, vm->locals, sizeof(h->locals));
+    memcpy(h->memory, vm->memory, sizeof(h->memory));
+
+    // Write to a temporary file and rename, so concurrent restores never see a partial snapshot
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    int ok = f != NULL;
+    if (ok) {
+        ok = fwrite(h, sizeof(SnapshotHeader), 1, f) == 1 &&
+             fseek(f, SNAPSHOT_HEAP_OFFSET, SEEK_SET) == 0 &&
+             fwrite(vm->heap, sizeof(int32_t), HEAP_SIZE, f) == HEAP_SIZE;
+        ok = (fclose(f) == 0) && ok;
+    }
+    free(h);
+    if (!ok || rename(tmp, path) != 0) {
+        perror(path);
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// Point the heap back at the VM's own storage, dropping a restored mapping
+static void vm_release_snapshot(VM *vm) {
+    if (!vm->snapshot_map) return;
+    munmap(vm->snapshot_map, HEAP_SIZE * sizeof(int32_t));
+    vm->snapshot_map = NULL;
+    vm->heap = vm->heap_storage;
+}
+
+// Check the object list of a mapped snapshot heap before the collector follows it.
+// vm_alloc() prepends each object at free_ptr and the sweep only unlinks, so a valid
+// list runs in strictly decreasing address order without overlaps; that also rules out
+// cycles. Returns NULL if the list is sound, or what is wrong with it.
+static const char *snapshot_check_heap(const int32_t *heap, int32_t free_ptr, int32_t list) {
+    int32_t limit = free_ptr; // Each object must end at or below the start of the previous one
+    for (int32_t obj = list; obj != -1; obj = heap[obj + 1]) {
+        if (obj < 0 || obj > limit - 3) return "Corrupt snapshot heap (object outside the heap)";
+        int32_t size = heap[obj];
+        if (size < 0 || size > limit - obj - 3) return "Corrupt snapshot heap (bad object size)";
+        if (heap[obj + 2] != 0) return "Corrupt snapshot heap (stale mark bit)";
+        limit = obj;
+    }
+    return NULL;
+}
+
+// Load a snapshot written for this VM's program. The heap is mapped MAP_PRIVATE,
+// so pages are only copied when the program writes them.
+// Returns 0 on success, -1 (with a message on stderr) on failure.
+int vm_snapshot_restore(VM *vm, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    const char *problem = NULL;
+    SnapshotHeader *h = malloc(sizeof(SnapshotHeader));
+    if (!h) {
+        problem = "Memory allocation failed";
+    } else if (pread(fd, h, sizeof(SnapshotHeader), 0) != (ssize_t)sizeof(SnapshotHeader) ||
+               memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic)) != 0) {
+        problem = "Not a snapshot file";
+    } else if (h->version != SNAPSHOT_VERSION || h->heap_words != HEAP_SIZE ||
+               h->heap_offset % (uint32_t)sysconf(_SC_PAGESIZE) != 0) {
+        problem = "Incompatible snapshot version";
+    } else if (h->code_size != vm->code_size || h->code_hash != code_hash(vm->code, vm->code_size)) {
+        problem = "Snapshot was taken from a different program";
+    } else if (h->pc < 0 || h->pc >= vm->code_size || h->sp < -1 || h->sp >= STACK_SIZE ||
+               h->rsp < -1 || h->rsp >= STACK_SIZE || h->free_ptr < 0 || h->free_ptr > HEAP_SIZE ||
+               h->allocated_list < -1 || h->allocated_list >= HEAP_SIZE ||
+               h->fp < 0 || h->frame_top < h->fp || h->frame_top > LOCALS_SIZE) {
+        problem = "Corrupt snapshot";
+    } else {
+        // Touching a mapping past the end of the file would raise SIGBUS
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)h->heap_offset + (off_t)(HEAP_SIZE * sizeof(int32_t)))
+            problem = "Truncated snapshot";
+    }
+
+    void *map = MAP_FAILED;
+    if (!problem) {
+        map = mmap(NULL, HEAP_SIZE * sizeof(int32_t), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, h->heap_offset);
+        if (map == MAP_FAILED) problem = "Cannot map snapshot heap";
+        else problem = snapshot_check_heap(map, h->free_ptr, h->allocated_list);
+        if (problem && map != MAP_FAILED) munmap(map, HEAP_SIZE * sizeof(int32_t));
+    }
+    close(fd); // The mapping keeps its own reference to the file
+
+    if (problem) {
+        fprintf(stderr, "Snapshot Error: %s (%s)\n", problem, path);
+        free(h);
+        return -1;
+    }
+
+    vm_release_snapshot(vm);
+    vm->snapshot_map = map;
+    vm->heap = map;
+    vm->pc = h->pc;
+    vm->sp = h->sp;
+    vm->rsp = h->rsp;
+    vm->free_ptr = h->free_ptr;
+    vm->allocated_list = h->allocated_list;
+    memset(vm->heap_starts, 0, sizeof(vm->heap_starts));
+    for (int32_t obj = vm->allocated_list; obj != -1; obj = vm->heap[obj + 1]) heap_set_start(vm, obj);
+    vm->fp = h->fp;
+    vm->frame_top = h->frame_top;
+    vm->stats_max_heap_used = h->free_ptr;
+    memcpy(vm->stack, h->stack, sizeof(vm->stack));
+    memcpy(vm->return_stack, h->return_stack, sizeof(vm->return_stack));
+    memcpy(vm->frame_stack, h->frame_stack, sizeof(vm->frame_stack));
+    memcpy(vm->locals, h->locals, sizeof(vm->locals));
+    memcpy(vm->memory, h->memory, sizeof(vm->memory));
+    free(h);
+    return 0;
+}
+
+// Arrange for a snapshot to be written when execution first reaches 'pc'.
+// The opcode there is swapped for SNAPSHOT_TRAP, so the dispatch loop pays nothing until then.
+void vm_snapshot_at(VM *vm, int pc, const char *path) {
+    vm->snapshot_pc = pc;
+    vm->snapshot_path = path;
+    vm->snapshot_opcode = vm->code[pc];
+    vm->code[pc] = SNAPSHOT_TRAP;
+}
+
+// The dispatch loop is instantiated twice: run_loop() passes a constant NULL profile so
+// every PROFILE_* hook folds away, run_loop_profiled() keeps them. Unprofiled runs
+// execute exactly the same handlers as before profiling existed.
+#define PROFILE_INSN(pc, op)          do { if (prof) profile_insn(prof, (pc), (op)); } while (0)
+#define PROFILE_BRANCH(pc, target)    do { if (prof) profile_branch(prof, (pc), (target)); } while (0)
+#define PROFILE_CALL(target)          do { if (prof) profile_call(prof, (target)); } while (0)
+
+// Back-edges and CALLs each burn one unit of fuel, bulk array opcodes one per
+// BULK_FUEL_ELEMENTS elements. At zero the VM stops after the instruction with the
+// state ready for vm_execute() to resume.
+#define CHARGE_FUEL_UNITS(n) do { if ((vm->fuel -= (n)) <= 0) { vm->suspended = VM_YIELDED; vm->running = 0; } } while (0)
+#define CHARGE_FUEL() CHARGE_FUEL_UNITS(1)
+
+static inline __attribute__((always_inline)) void dispatch(VM *vm, Profile *prof) {
     // We assume the code size is large enough or trusted, assuming proper loader checks.
     // In a real VM, you'd also check bounds of vm->pc against code size.
 
     while (vm->running) {
+        int insn_pc = vm->pc;
         uint8_t opcode = vm->code[vm->pc++];
+        // A SNAPSHOT_TRAP re-dispatches the real opcode at the same pc, which is counted then
+        if (opcode != SNAPSHOT_TRAP) PROFILE_INSN(insn_pc, opcode);
         switch (opcode) {
         // 1.6.1 Data Movement
         case PUSH: {
@@ -187,6 +736,7 @@ void run_vm(VM *vm) {
         }
         case HALT: {
             vm->running = 0;
+            io_flush();
             break;
         }
 
@@ -227,20 +777,30 @@ void run_vm(VM *vm) {
         // 1.6.3 Control Flow
         case JMP: {
             vm->pc = *(int32_t*)&vm->code[vm->pc];
+            PROFILE_BRANCH(insn_pc, vm->pc);
+            if (vm->pc <= insn_pc) CHARGE_FUEL();
             break;
         }
         case JZ: {
             int32_t addr = *(int32_t*)&vm->code[vm->pc];
             vm->pc += 4;
             int32_t val = pop(vm);
-            if (vm->running && val == 0) vm->pc = addr;
+            if (vm->running && val == 0) {
+                vm->pc = addr;
+                PROFILE_BRANCH(insn_pc, addr);
+                if (addr <= insn_pc) CHARGE_FUEL();
+            }
             break;
         }
         case JNZ: {
             int32_t addr = *(int32_t*)&vm->code[vm->pc];
             vm->pc += 4;
             int32_t val = pop(vm);
-            if (vm->running && val != 0) vm->pc = addr;
+            if (vm->running && val != 0) {
+                vm->pc = addr;
+                PROFILE_BRANCH(insn_pc, addr);
+                if (addr <= insn_pc) CHARGE_FUEL();
+            }
             break;
         }
 
@@ -283,6 +843,43 @@ void run_vm(VM *vm) {
             }
             break;
         }
+        case LOADI: {
+            int32_t idx = pop(vm);
+            if (!vm->running) break;
+            int32_t *slot = memory_slot(vm, idx);
+            if (slot) push(vm, *slot);
+            break;
+        }
+        case STOREI: {
+            int32_t idx = pop(vm);
+            int32_t val = pop(vm);
+            if (!vm->running) break;
+            int32_t *slot = memory_slot(vm, idx);
+            if (slot) *slot = val;
+            break;
+        }
+        case LOAD_LOCAL: {
+            int32_t idx = *(int32_t*)&vm->code[vm->pc];
+            vm->pc += 4;
+            if (idx < 0 || idx >= vm->frame_top - vm->fp) {
+                error(vm, "Invalid Local");
+                break;
+            }
+            push(vm, vm->locals[vm->fp + idx]);
+            break;
+        }
+        case STORE_LOCAL: {
+            int32_t idx = *(int32_t*)&vm->code[vm->pc];
+            vm->pc += 4;
+            int32_t val = pop(vm);
+            if (!vm->running) break;
+            if (idx < 0 || idx >= vm->frame_top - vm->fp) {
+                error(vm, "Invalid Local");
+                break;
+            }
+            vm->locals[vm->fp + idx] = val;
+            break;
+        }
         case CALL: {
             uint32_t addr = *(uint32_t*)&vm->code[vm->pc];
             vm->pc += 4;
@@ -292,7 +889,12 @@ void run_vm(VM *vm) {
                 break;
             }
             vm->return_stack[++vm->rsp] = vm->pc; 
+            // The callee's frame starts (empty) right after the caller's
+            vm->frame_stack[vm->rsp] = vm->fp;
+            vm->fp = vm->frame_top;
             vm->pc = addr;
+            PROFILE_CALL((int)addr);
+            CHARGE_FUEL();
             break;
         }
         case RET: {
@@ -300,9 +902,31 @@ void run_vm(VM *vm) {
                 error(vm, "Return Stack Underflow");
                 break;
             }
+            vm->frame_top = vm->fp;
+            vm->fp = vm->frame_stack[vm->rsp];
             vm->pc = vm->return_stack[vm->rsp--];
             break;
         }
+        case ENTER: {
+            int32_t n = *(int32_t*)&vm->code[vm->pc];
+            vm->pc += 4;
+            // Only at a function entry: pc 0 in the main frame, else the target of the
+            // CALL that opened this frame (its immediate ends at the return address)
+            uint32_t ret = vm->rsp >= 0 ? vm->return_stack[vm->rsp] : 0;
+            int32_t entry = vm->rsp < 0 ? 0 : (ret >= 5 && ret <= (uint32_t)vm->code_size)
+                                              ? *(int32_t*)&vm->code[ret - 4] : -1;
+            if (insn_pc != entry) {
+                error(vm, "Misplaced ENTER");
+                break;
+            }
+            if (n < 0 || n > LOCALS_SIZE - vm->fp) {
+                error(vm, "Frame Stack Overflow");
+                break;
+            }
+            memset(&vm->locals[vm->fp], 0, n * sizeof(int32_t));
+            vm->frame_top = vm->fp + n;
+            break;
+        }
 
         // 1.6.5 Standard Library
         case PRINT: {
@@ -310,59 +934,89 @@ void run_vm(VM *vm) {
                 error(vm, "Stack Underflow");
                 break;
             }
-            printf("%d\n", vm->stack[vm->sp--]);
-            fflush(stdout);
+            io_write_int(vm->stack[vm->sp--]);
             break;
         }
         case INPUT: {
-            int val;
-            printf("Enter number: ");
-            if (scanf("%d", &val) == 1) {
-                if (vm->sp >= STACK_SIZE - 1) {
-                    error(vm, "Stack Overflow");
+            int32_t val;
+            if (vm->inbox) {
+                // Scheduled: wait for sched_send() instead of reading stdin
+                if (!inbox_take(vm->inbox, &val)) {
+                    vm->pc = insn_pc;
+                    vm->suspended = VM_BLOCKED;
+                    vm->running = 0;
                     break;
                 }
-                vm->stack[++vm->sp] = val;
             } else {
-                fprintf(stderr, "Error: Invalid input\n");
-                vm->running = 0;
-                vm->error = 1;
+                io_prompt("Enter number: ");
+                if (!io_read_int(&val)) {
+                    io_flush();
+                    fprintf(stderr, "Error: Invalid input\n");
+                    vm->running = 0;
+                    vm->error = 1;
+                    break;
+                }
+            }
+            if (vm->sp >= STACK_SIZE - 1) {
+                error(vm, "Stack Overflow");
+                break;
             }
+            vm->stack[++vm->sp] = val;
             break;
         }
 
         case ALLOC: {
             int32_t size = pop(vm);
-            if (size < 0) { error(vm, "Invalid Allocation Size"); break; }
-            
-            // Header: 3 words [Size, Next, Marked]
-            int needed = size + 3; 
-            if (vm->free_ptr + needed > HEAP_SIZE) {
-                vm_gc(vm); // Trigger Garbage Collection
-                if (vm->free_ptr + needed > HEAP_SIZE) { // Retry Allocation
-                    error(vm, "Heap Overflow");
-                    break;
-                }
-            }
+            if (!vm->running) break;
+            int32_t addr = vm_alloc(vm, size);
+            if (vm->running) push(vm, addr);
+            break;
+        }
 
-            int32_t addr = vm->free_ptr;
-            vm->heap[addr] = size;                     // Header[0]: Size
-            vm->heap[addr + 1] = vm->allocated_list;   // Header[1]: Next Object
-            vm->heap[addr + 2] = 0;                    // Header[2]: Mark Bit
-            
-            vm->allocated_list = addr;                 // Update List Head
-            vm->free_ptr += needed;                    // Advance Pointer
-            
-            if (vm->free_ptr > vm->stats_max_heap_used) {
-                vm->stats_max_heap_used = vm->free_ptr;
+        // Bulk Array Operations
+        case AFILL:
+        case ACOPY:
+        case AADD:
+        case AMUL: {
+            int32_t b = pop(vm);
+            int32_t a = pop(vm);
+            if (!vm->running) break;
+            int32_t units;
+            bulk_op(vm, opcode, a, b, &units);
+            if (vm->running && units > 0) CHARGE_FUEL_UNITS(units);
+            break;
+        }
+        case ASUM:
+        case AMIN:
+        case AMAX: {
+            int32_t a = pop(vm);
+            if (!vm->running) break;
+            int32_t units;
+            int32_t result = bulk_op(vm, opcode, a, 0, &units);
+            if (!vm->running) break;
+            push(vm, result);
+            if (units > 0) CHARGE_FUEL_UNITS(units);
+            break;
+        }
+
+        case SNAPSHOT_TRAP: {
+            if (insn_pc != vm->snapshot_pc) goto unknown_opcode;
+            // Put the real instruction back, snapshot the state before it, then run it
+            vm->code[insn_pc] = vm->snapshot_opcode;
+            vm->snapshot_pc = -1;
+            vm->pc = insn_pc;
+            io_flush();
+            if (vm_snapshot_write(vm, vm->snapshot_path) == 0) {
+                fprintf(stderr, "Snapshot written to %s\n", vm->snapshot_path);
+            } else {
+                error(vm, "Snapshot Failed");
             }
-            
-            // Push address of payload (skip header) to stack
-            push(vm, MEM_SIZE + addr + 3);
             break;
         }
 
         default:
+        unknown_opcode:
+            io_flush();
             fprintf(stderr, "Unknown Opcode: 0x%02X\n", opcode);
             vm->running = 0;
             vm->error = 1;
@@ -370,6 +1024,591 @@ void run_vm(VM *vm) {
     }
 }
 
+static void run_loop(VM *vm) {
+    dispatch(vm, NULL);
+}
+
+static void run_loop_profiled(VM *vm) {
+    dispatch(vm, vm->profile);
+}
+
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Reset execution state and the heap before a run
+static void vm_reset(VM *vm) {
+    vm->pc = 0;
+    vm->sp = -1;
+    vm->rsp = -1;
+    vm->fp = 0;
+    vm->frame_top = 0;
+    vm->running = 1;
+    vm->error = 0;
+    vm->suspended = 0;
+    vm->free_ptr = 0; // Initialize heap pointer to start
+    vm->allocated_list = -1; // -1 denotes end of linked list
+    memset(vm->heap_starts, 0, sizeof(vm->heap_starts));
+    vm->stats_gc_runs = 0;
+    vm->stats_freed_objects = 0;
+    vm->stats_total_gc_time = 0.0;
+    vm->stats_max_heap_used = 0;
+    vm->gc_record_count = 0;
+    vm->gc_words_allocated = 0;
+    vm->gc_last_end = 0;
+    vm->gc_epoch = monotonic_seconds();
+    vm->jit_stack_lo = vm->jit_stack_hi = NULL;
+    vm_release_snapshot(vm);
+}
+
+// Run from the current state (e.g. after vm_snapshot_restore, or a previous
+// VM_YIELDED / VM_BLOCKED return) until HALT, an error, or the fuel runs out
+VMStatus vm_execute(VM *vm) {
+    vm->running = 1;
+    vm->suspended = 0;
+    if (vm->profile) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        run_loop_profiled(vm);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        vm->profile->elapsed += elapsed_seconds(&start, &end);
+    } else {
+        run_loop(vm);
+    }
+    if (vm->error) return VM_ERROR;
+    return vm->suspended ? (VMStatus)vm->suspended : VM_HALTED;
+}
+
+VMStatus run_vm(VM *vm) {
+    vm_reset(vm);
+    return vm_execute(vm);
+}
+
+// Scheduler: multiplexes many VMs on one thread. Each task runs for a slice of
+// s->quantum fuel and then goes to the back of the run queue; INPUT with an empty
+// inbox blocks it until sched_send(). Interpreted tasks stop at the end of a slice
+// by returning from vm_execute(). Compiled code keeps its operand and return stacks
+// on the native stack, so JIT tasks run as coroutines on their own stacks and
+// switch back to the scheduler from inside the runtime helpers.
+// Stacks are reserved lazily (MAP_NORESERVE); their size covers GC marking, which
+// recurses once per object along a chain, up to HEAP_SIZE / 4 deep.
+#define SCHED_JIT_STACK_SIZE (2 * 1024 * 1024)
+
+typedef enum { SCHED_ROUND_ROBIN, SCHED_PRIORITY } SchedPolicy;
+
+typedef struct Task {
+    VM *vm;
+    int id;
+    int priority;          // SCHED_PRIORITY: higher runs first, FIFO among equals
+    VMStatus status;       // VM_YIELDED while runnable
+    int result;            // Top of stack once VM_HALTED
+    uint64_t seq;          // Run queue order
+    uint64_t slices;
+    Inbox inbox;
+    // Compiled tasks
+    jit_func fn;
+    void *stack;           // SCHED_JIT_STACK_SIZE bytes, lowest page a guard
+    void *sp;              // Saved stack pointer while switched out (NULL = not started)
+    void **sched_sp;       // Where the scheduler's is saved
+} Task;
+
+// Coroutine switch: push the callee-saved registers, save rsp in *save, then load
+// 'next' and pop its registers. swapcontext() would also save and restore the signal
+// mask, two system calls per switch. A new task's stack is laid out by task_stack().
+void vm_sched_switch(void **save, void *next);
+void vm_task_entry(void);
+__asm__(
+    ".text\n"
+    ".globl vm_sched_switch\n"
+    ".type vm_sched_switch, @function\n"
+    "vm_sched_switch:\n"
+    "    push %rbp\n"
+    "    push %rbx\n"
+    "    push %r12\n"
+    "    push %r13\n"
+    "    push %r14\n"
+    "    push %r15\n"
+    "    mov %rsp, (%rdi)\n"
+    "    mov %rsi, %rsp\n"
+    "    pop %r15\n"
+    "    pop %r14\n"
+    "    pop %r13\n"
+    "    pop %r12\n"
+    "    pop %rbx\n"
+    "    pop %rbp\n"
+    "    ret\n"
+    ".size vm_sched_switch, .-vm_sched_switch\n"
+    // First switch into a task: call r12(rbx) on the fresh, 16-byte aligned stack
+    ".globl vm_task_entry\n"
+    ".type vm_task_entry, @function\n"
+    "vm_task_entry:\n"
+    "    mov %rbx, %rdi\n"
+    "    call *%r12\n"
+    "    ud2\n"
+    ".size vm_task_entry, .-vm_task_entry\n");
+
+// Switch from compiled code back to the scheduler; returns once the task is resumed
+static void task_suspend(VM *vm, VMStatus why) {
+    Task *t = vm->task;
+    t->status = why;
+    vm_sched_switch(&t->sp, *t->sched_sp);
+}
+
+// JIT Runtime Helpers: called from compiled code with the VM as context.
+// A failed operation has already reported its error; unwind to vm_run_jit.
+// They are not static: AOT objects link against them by name (jit_helper_symbols).
+int32_t vm_rt_alloc(void *ctx, int64_t size, int64_t *sp, int64_t *base) {
+    VM *vm = ctx;
+    vm->jit_stack_lo = sp;
+    vm->jit_stack_hi = base;
+    int32_t addr = vm_alloc(vm, (int32_t)size);
+    vm->jit_stack_lo = vm->jit_stack_hi = NULL;
+    if (!vm->running) longjmp(vm->jit_trap, 1);
+    return addr;
+}
+
+int32_t vm_rt_load(void *ctx, int64_t addr) {
+    VM *vm = ctx;
+    int32_t *slot = memory_slot(vm, (int32_t)addr);
+    if (!slot) longjmp(vm->jit_trap, 1);
+    return *slot;
+}
+
+void vm_rt_store(void *ctx, int64_t addr, int64_t val) {
+    VM *vm = ctx;
+    int32_t *slot = memory_slot(vm, (int32_t)addr);
+    if (!slot) longjmp(vm->jit_trap, 1);
+    *slot = (int32_t)val;
+}
+
+void vm_rt_trap(void *ctx, int trap) {
+    static const char *messages[JIT_TRAP_COUNT] = {
+        [JIT_TRAP_STACK_OVERFLOW] = "Stack Overflow",
+        [JIT_TRAP_RETURN_OVERFLOW] = "Return Stack Overflow",
+        [JIT_TRAP_RETURN_UNDERFLOW] = "Return Stack Underflow",
+        [JIT_TRAP_DIVISION_BY_ZERO] = "Division by Zero",
+        [JIT_TRAP_FRAME_OVERFLOW]   = "Frame Stack Overflow",
+        [JIT_TRAP_INVALID_LOCAL]    = "Invalid Local",
+        [JIT_TRAP_MISPLACED_ENTER]  = "Misplaced ENTER",
+    };
+    VM *vm = ctx;
+    error(vm, messages[trap]);
+    longjmp(vm->jit_trap, 1);
+}
+
+void vm_rt_print(void *ctx, int64_t val) {
+    (void)ctx;
+    io_write_int((int32_t)val);
+}
+
+int32_t vm_rt_input(void *ctx) {
+    VM *vm = ctx;
+    int32_t val;
+    if (vm->task) {
+        while (!inbox_take(vm->inbox, &val)) task_suspend(vm, VM_BLOCKED);
+        return val;
+    }
+    io_prompt("Enter number: ");
+    if (!io_read_int(&val)) {
+        io_flush();
+        fprintf(stderr, "Error: Invalid input\n");
+        vm->running = 0;
+        vm->error = 1;
+        longjmp(vm->jit_trap, 1);
+    }
+    return val;
+}
+
+// Budget for compiled code, which counts fuel down in its own frame. Only scheduled
+// tasks can be suspended, so other runs are not metered.
+static int32_t jit_fuel_budget(VM *vm) {
+    if (!vm->task || vm->fuel > INT32_MAX) return INT32_MAX;
+    return vm->fuel > 0 ? (int32_t)vm->fuel : 1;
+}
+
+int32_t vm_rt_fuel(void *ctx) {
+    return jit_fuel_budget(ctx);
+}
+
+int32_t vm_rt_yield(void *ctx) {
+    VM *vm = ctx;
+    if (vm->task) {
+        vm->fuel = 0;
+        task_suspend(vm, VM_YIELDED); // The scheduler refills vm->fuel
+    }
+    return jit_fuel_budget(vm);
+}
+
+// *fuel is the compiled code's counter, spilled around the call: charge the
+// operation's length, yielding like JIT_HELPER_YIELD if that uses it up
+int32_t vm_rt_bulk(void *ctx, int op, int64_t a, int64_t b, int64_t *fuel) {
+    VM *vm = ctx;
+    int32_t units;
+    int32_t result = bulk_op(vm, (uint8_t)op, (int32_t)a, (int32_t)b, &units);
+    if (!vm->running) longjmp(vm->jit_trap, 1);
+    if (units > 0 && (*fuel -= units) <= 0) *fuel = vm_rt_yield(vm);
+    return result;
+}
+
+// Compile the VM's program, wiring compiled code to this VM's runtime helpers
+jit_func vm_compile(VM *vm) {
+    JitRuntime rt = { .helpers = {
+        [JIT_HELPER_ALLOC] = (void *)vm_rt_alloc,
+        [JIT_HELPER_LOAD]  = (void *)vm_rt_load,
+        [JIT_HELPER_STORE] = (void *)vm_rt_store,
+        [JIT_HELPER_BULK]  = (void *)vm_rt_bulk,
+        [JIT_HELPER_TRAP]  = (void *)vm_rt_trap,
+        [JIT_HELPER_PRINT] = (void *)vm_rt_print,
+        [JIT_HELPER_INPUT] = (void *)vm_rt_input,
+        [JIT_HELPER_FUEL]  = (void *)vm_rt_fuel,
+        [JIT_HELPER_YIELD] = (void *)vm_rt_yield,
+    } };
+    jit_set_runtime(&rt);
+    return compile(vm->code, vm->code_size);
+}
+
+// Run compiled code on a freshly reset VM. Returns 0 and the top of the stack in
+// *result, or -1 if a runtime error stopped execution.
+int vm_run_jit(VM *vm, jit_func fn, int *result) {
+    vm_reset(vm);
+    if (setjmp(vm->jit_trap)) {
+        vm->jit_stack_lo = vm->jit_stack_hi = NULL;
+        return -1;
+    }
+    *result = fn(vm);
+    vm->running = 0;
+    return 0;
+}
+
+typedef struct {
+    SchedPolicy policy;
+    int64_t quantum;       // Fuel per slice
+    Task **tasks;          // By id
+    int count;
+    int cap;
+    Task **queue;          // Runnable tasks, a binary heap ordered by sched_before()
+    int queued;
+    uint64_t seq;
+    void *sp;              // Saved stack pointer while a compiled task runs
+    // Statistics
+    uint64_t slices;
+    double run_time;       // Time spent inside slices
+    double max_slice;      // Longest a single slice held the thread
+} Scheduler;
+
+void sched_init(Scheduler *s, SchedPolicy policy, int64_t quantum) {
+    memset(s, 0, sizeof(*s));
+    s->policy = policy;
+    s->quantum = quantum > 0 ? quantum : 1;
+}
+
+static int sched_before(const Scheduler *s, const Task *a, const Task *b) {
+    if (s->policy == SCHED_PRIORITY && a->priority != b->priority) return a->priority > b->priority;
+    return a->seq < b->seq;
+}
+
+// Make 't' runnable. The queue has room for every task, and a task is queued at most once.
+static void sched_push(Scheduler *s, Task *t) {
+    t->seq = s->seq++;
+    int i = s->queued++;
+    while (i > 0 && sched_before(s, t, s->queue[(i - 1) / 2])) {
+        s->queue[i] = s->queue[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    s->queue[i] = t;
+}
+
+static Task *sched_pop(Scheduler *s) {
+    Task *top = s->queue[0];
+    Task *last = s->queue[--s->queued];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= s->queued) break;
+        if (child + 1 < s->queued && sched_before(s, s->queue[child + 1], s->queue[child])) child++;
+        if (!sched_before(s, s->queue[child], last)) break;
+        s->queue[i] = s->queue[child];
+        i = child;
+    }
+    s->queue[i] = last;
+    return top;
+}
+
+// Add a task that runs 'code' (shared, not copied) from pc 0, compiled if 'fn' (from
+// vm_compile() of the same code) is given. Returns NULL when out of memory.
+Task *sched_spawn(Scheduler *s, uint8_t *code, int code_size, jit_func fn, int priority) {
+    if (s->count == s->cap) {
+        int cap = s->cap ? s->cap * 2 : 64;
+        Task **tasks = realloc(s->tasks, cap * sizeof(Task *));
+        if (!tasks) return NULL;
+        s->tasks = tasks;
+        Task **queue = realloc(s->queue, cap * sizeof(Task *));
+        if (!queue) return NULL;
+        s->queue = queue;
+        s->cap = cap;
+    }
+    Task *t = calloc(1, sizeof(Task));
+    VM *vm = t ? vm_create() : NULL;
+    if (!vm) {
+        free(t);
+        return NULL;
+    }
+    if (fn) {
+        t->stack = mmap(NULL, SCHED_JIT_STACK_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (t->stack == MAP_FAILED || mprotect(t->stack, getpagesize(), PROT_NONE) != 0) {
+            if (t->stack != MAP_FAILED) munmap(t->stack, SCHED_JIT_STACK_SIZE);
+            free(vm);
+            free(t);
+            return NULL;
+        }
+        vm->task = t;
+    }
+    vm->code = code;
+    vm->code_size = code_size;
+    vm->inbox = &t->inbox;
+    vm_reset(vm);
+    t->vm = vm;
+    t->id = s->count;
+    t->priority = priority;
+    t->status = VM_YIELDED;
+    t->fn = fn;
+    t->sched_sp = &s->sp;
+    s->tasks[s->count++] = t;
+    sched_push(s, t);
+    return t;
+}
+
+// Body of a compiled task's coroutine. It ends by switching to the scheduler for the
+// last time; the stack is unmapped once the task is done.
+static void task_main(Task *t) {
+    int result = 0;
+    t->status = vm_run_jit(t->vm, t->fn, &result) == 0 ? VM_HALTED : VM_ERROR;
+    t->result = result;
+    vm_sched_switch(&t->sp, *t->sched_sp);
+}
+
+// Initial stack of a compiled task: the registers vm_sched_switch() pops, with
+// rbx = t and r12 = task_main, returning into vm_task_entry
+static void task_stack(Task *t) {
+    void **sp = (void **)((char *)t->stack + SCHED_JIT_STACK_SIZE);
+    *--sp = (void *)vm_task_entry;
+    *--sp = NULL;              // rbp
+    *--sp = t;                 // rbx
+    *--sp = (void *)task_main; // r12
+    *--sp = NULL;              // r13
+    *--sp = NULL;              // r14
+    *--sp = NULL;              // r15
+    t->sp = sp;
+}
+
+static void sched_slice(Scheduler *s, Task *t) {
+    VM *vm = t->vm;
+    vm->fuel = s->quantum;
+    double start = monotonic_seconds();
+    if (t->fn) {
+        if (!t->sp) task_stack(t);
+        vm_sched_switch(&s->sp, t->sp);
+    } else {
+        t->status = vm_execute(vm);
+        if (t->status == VM_HALTED && vm->sp >= 0) t->result = vm->stack[vm->sp];
+    }
+    double elapsed = monotonic_seconds() - start;
+    s->run_time += elapsed;
+    if (elapsed > s->max_slice) s->max_slice = elapsed;
+    s->slices++;
+    t->slices++;
+
+    if (t->status == VM_YIELDED) {
+        sched_push(s, t);
+    } else if ((t->status == VM_HALTED || t->status == VM_ERROR) && t->stack) {
+        munmap(t->stack, SCHED_JIT_STACK_SIZE);
+        t->stack = NULL;
+    }
+}
+
+// Run until every task has finished or is blocked on INPUT. Returns the number of
+// blocked tasks, which sched_send() can wake for another sched_run().
+int sched_run(Scheduler *s) {
+    while (s->queued > 0) sched_slice(s, sched_pop(s));
+    int blocked = 0;
+    for (int i = 0; i < s->count; i++) {
+        if (s->tasks[i]->status == VM_BLOCKED) blocked++;
+    }
+    return blocked;
+}
+
+// Queue 'val' for the task's next INPUT, making it runnable if it is blocked
+int sched_send(Scheduler *s, Task *t, int32_t val) {
+    if (inbox_put(&t->inbox, val) != 0) return -1;
+    if (t->status == VM_BLOCKED) {
+        t->status = VM_YIELDED;
+        sched_push(s, t);
+    }
+    return 0;
+}
+
+void sched_free(Scheduler *s) {
+    for (int i = 0; i < s->count; i++) {
+        Task *t = s->tasks[i];
+        if (t->stack) munmap(t->stack, SCHED_JIT_STACK_SIZE);
+        free(t->inbox.values);
+        free(t->vm->gc_records);
+        free(t->vm);
+        free(t);
+    }
+    free(s->tasks);
+    free(s->queue);
+    memset(s, 0, sizeof(*s));
+}
+
+#ifdef AOT_RUNTIME
+// Standalone executables from --aot-exe: this runtime around the compiled program
+extern int vm_program(void *ctx); // AOT_ENTRY_SYMBOL
+
+int main(int argc, char **argv) {
+    VM vm;
+    vm_init(&vm);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--binary-io") == 0) {
+            io_set_mode(IO_MODE_BINARY);
+        } else if (strcmp(argv[i], "--gc-stress") == 0) {
+            vm.gc_stress = 1;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    int result;
+    if (vm_run_jit(&vm, vm_program, &result) == 0) {
+        io_printf("Top of stack: %d\n", result);
+    }
+    free(vm.gc_records);
+    io_flush();
+    return vm.error ? 1 : 0;
+}
+
+#else
+
+// Default snapshot file: program.bin -> program.snap
+static void snapshot_default_path(const char *bin_path, char *buf, int len) {
+    size_t n = strlen(bin_path);
+    if (n > 4 && strcmp(bin_path + n - 4, ".bin") == 0) {
+        snprintf(buf, len, "%.*s.snap", (int)(n - 4), bin_path);
+    } else {
+        snprintf(buf, len, "%s.snap", bin_path);
+    }
+}
+
+// Collection totals and pause percentiles, printed after a run that collected
+static void print_gc_summary(const VM *vm) {
+    if (vm->stats_gc_runs == 0) return;
+    io_printf("[GC Stats] Runs: %d, Freed: %d, Total GC Time: %.6fs, Max Heap: %d words\n", 
+        vm->stats_gc_runs, vm->stats_freed_objects, vm->stats_total_gc_time, vm->stats_max_heap_used);
+    GCPauseSummary pauses;
+    vm_gc_pause_summary(vm, &pauses);
+    io_printf("[GC Pauses] p50: %.1fus, p99: %.1fus, Max: %.1fus\n",
+        pauses.p50 * 1e6, pauses.p99 * 1e6, pauses.max * 1e6);
+}
+
+// Assembly source of a bytecode file: program.bin -> program.asm
+static void source_default_path(const char *bin_path, char *buf, int len) {
+    size_t n = strlen(bin_path);
+    if (n > 4 && strcmp(bin_path + n - 4, ".bin") == 0) {
+        snprintf(buf, len, "%.*s.asm", (int)(n - 4), bin_path);
+    } else {
+        snprintf(buf, len, "%s.asm", bin_path);
+    }
+}
+
+// Compile ahead of time to 'out': an ELF object, or with 'link' an executable
+// linked against the runtime library. Returns 0 on success.
+static int aot_compile(VM *vm, const char *sym_path, const char *out, int link) {
+    SymTab syms;
+    symtab_load(&syms, sym_path); // Optional: labels only name the symbols
+    JitObject obj;
+    int status = compile_object(vm->code, vm->code_size, &syms, &obj);
+    symtab_free(&syms);
+    if (status != 0) return -1;
+
+    char obj_path[512];
+    snprintf(obj_path, sizeof(obj_path), link ? "%s.o" : "%s", out);
+    status = aot_write_object(&obj, AOT_ENTRY_SYMBOL, obj_path);
+    jit_object_free(&obj);
+    if (status != 0) {
+        fprintf(stderr, "Error writing %s\n", obj_path);
+        return -1;
+    }
+    if (link) {
+        char runtime[512];
+        aot_default_runtime(runtime, sizeof(runtime));
+        status = aot_link(obj_path, runtime, out);
+        unlink(obj_path);
+        if (status != 0) {
+            fprintf(stderr, "Linking %s against %s failed\n", out, runtime);
+            return -1;
+        }
+    }
+    io_printf("AOT: wrote %s\n", out);
+    return 0;
+}
+
+// Run 'tenants' instances of vm's program on this thread, 'quantum' fuel per slice.
+// When every task is done or blocked, the next stdin value goes to the lowest-numbered
+// blocked task. Returns the process exit status.
+static int run_tenants(VM *vm, int tenants, int64_t quantum, int use_jit) {
+    jit_func fn = NULL;
+    if (use_jit && !(fn = vm_compile(vm))) {
+        fprintf(stderr, "JIT Compilation Failed\n");
+        return 1;
+    }
+    Scheduler s;
+    sched_init(&s, SCHED_ROUND_ROBIN, quantum);
+    for (int i = 0; i < tenants; i++) {
+        Task *t = sched_spawn(&s, vm->code, vm->code_size, fn, 0);
+        if (!t) {
+            fprintf(stderr, "Memory allocation failed\n");
+            sched_free(&s);
+            return 1;
+        }
+        t->vm->gc_stress = vm->gc_stress;
+    }
+
+    int status = 0;
+    while (sched_run(&s) > 0) {
+        Task *t = NULL;
+        for (int i = 0; !t && i < s.count; i++) {
+            if (s.tasks[i]->status == VM_BLOCKED) t = s.tasks[i];
+        }
+        int32_t val;
+        io_prompt("Enter number: ");
+        if (!io_read_int(&val)) {
+            io_flush();
+            fprintf(stderr, "Error: Invalid input\n");
+            break;
+        }
+        if (sched_send(&s, t, val) != 0) {
+            fprintf(stderr, "Memory allocation failed\n");
+            break;
+        }
+    }
+
+    for (int i = 0; i < s.count; i++) {
+        Task *t = s.tasks[i];
+        if (t->status == VM_HALTED) {
+            io_printf("Task %d: Top of stack: %d\n", t->id, t->result);
+        } else {
+            io_printf("Task %d: %s\n", t->id, t->status == VM_BLOCKED ? "Blocked on INPUT" : "Error");
+            status = 1;
+        }
+    }
+    io_printf("[Sched] Tasks: %d, Slices: %llu, Run time: %.6fs, Max slice: %.1fus\n",
+              s.count, (unsigned long long)s.slices, s.run_time, s.max_slice * 1e6);
+    sched_free(&s);
+    return status;
+}
+
 #ifndef TESTING
 int main(int argc, char **argv) {
 #else
@@ -395,39 +1634,211 @@ int run_vm_main(int argc, char **argv) {
     fread(code, 1, size, f);
     fclose(f);
 
-    VM vm = { .code = code };
+    VM vm;
+    vm_init(&vm);
+    vm.code = code;
+    vm.code_size = (int)size;
 
-    // Check for JIT flag
+    // Parse flags
     int use_jit = 0;
-    if (argc > 2 && strcmp(argv[2], "--jit") == 0) {
-        use_jit = 1;
+    int perf_flags = 0;
+    const char *profile_path = NULL;
+    const char *gc_log_path = NULL;
+    const char *snapshot_label = NULL;
+    const char *restore_path = NULL;
+    const char *aot_path = NULL;
+    int aot_link_exe = 0;
+    int tenants = 0;
+    int64_t quantum = 10000;
+    char sym_path[512];
+    char snapshot_path[512];
+    symtab_default_path(argv[1], sym_path, sizeof(sym_path));
+    snapshot_default_path(argv[1], snapshot_path, sizeof(snapshot_path));
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--jit") == 0) {
+            use_jit = 1;
+        } else if (strcmp(argv[i], "--binary-io") == 0) {
+            io_set_mode(IO_MODE_BINARY);
+        } else if (strcmp(argv[i], "--perf-map") == 0) {
+            perf_flags |= JIT_PERF_MAP;
+        } else if (strcmp(argv[i], "--jitdump") == 0) {
+            perf_flags |= JIT_PERF_DUMP;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile_path = "profile.json";
+        } else if (strncmp(argv[i], "--profile=", 10) == 0) {
+            profile_path = argv[i] + 10;
+        } else if (strcmp(argv[i], "--gc-stress") == 0) {
+            vm.gc_stress = 1;
+        } else if (strncmp(argv[i], "--gc-log=", 9) == 0) {
+            gc_log_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--snapshot-at=", 14) == 0) {
+            snapshot_label = argv[i] + 14;
+        } else if (strncmp(argv[i], "--snapshot-file=", 16) == 0) {
+            snprintf(snapshot_path, sizeof(snapshot_path), "%s", argv[i] + 16);
+        } else if (strncmp(argv[i], "--restore=", 10) == 0) {
+            restore_path = argv[i] + 10;
+        } else if (strncmp(argv[i], "--aot=", 6) == 0) {
+            aot_path = argv[i] + 6;
+            aot_link_exe = 0;
+        } else if (strncmp(argv[i], "--aot-exe=", 10) == 0) {
+            aot_path = argv[i] + 10;
+            aot_link_exe = 1;
+        } else if (strncmp(argv[i], "--sym=", 6) == 0) {
+            snprintf(sym_path, sizeof(sym_path), "%s", argv[i] + 6);
+        } else if (strncmp(argv[i], "--tenants=", 10) == 0) {
+            tenants = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--fuel=", 7) == 0) {
+            quantum = atoll(argv[i] + 7);
+        } else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            free(code);
+            return 1;
+        }
+    }
+
+    if (profile_path && use_jit) {
+        fprintf(stderr, "--profile is only supported by the interpreter\n");
+        free(code);
+        return 1;
+    }
+    if ((snapshot_label || restore_path) && use_jit) {
+        fprintf(stderr, "--snapshot-at and --restore are only supported by the interpreter\n");
+        free(code);
+        return 1;
+    }
+
+    if (tenants > 0) {
+        if (profile_path || gc_log_path || snapshot_label || restore_path || aot_path) {
+            fprintf(stderr, "--tenants only supports --jit, --gc-stress and --fuel\n");
+            free(code);
+            return 1;
+        }
+        if (use_jit) {
+            io_printf("Running with JIT...\n");
+            io_flush();
+        }
+        int status = run_tenants(&vm, tenants, quantum, use_jit);
+        io_flush();
+        free(code);
+        return status;
+    }
+
+    if (aot_path) {
+        if (use_jit || profile_path || snapshot_label || restore_path) {
+            fprintf(stderr, "--aot and --aot-exe only compile; drop the run options\n");
+            free(code);
+            return 1;
+        }
+        int status = aot_compile(&vm, sym_path, aot_path, aot_link_exe);
+        io_flush();
+        free(code);
+        return status == 0 ? 0 : 1;
+    }
+
+    if (snapshot_label) {
+        SymTab syms;
+        symtab_load(&syms, sym_path);
+        const Symbol *label = symtab_find(&syms, snapshot_label);
+        int pc = label ? label->addr : -1;
+        symtab_free(&syms);
+        if (pc < 0 || pc >= vm.code_size) {
+            fprintf(stderr, "Unknown label %s (assemble with --sym, or pass --sym=<file>)\n", snapshot_label);
+            free(code);
+            return 1;
+        }
+        vm_snapshot_at(&vm, pc, snapshot_path);
+    }
+
+    if (gc_log_path) {
+        vm.gc_log = fopen(gc_log_path, "w");
+        if (!vm.gc_log) {
+            perror(gc_log_path);
+            free(code);
+            return 1;
+        }
     }
 
     if (use_jit) {
-        printf("Running with JIT...\n");
-        jit_func jitted_code = compile(code, size);
+        io_printf("Running with JIT...\n");
+        io_flush();
+        SymTab syms = { 0 };
+        char asm_path[512];
+        if (perf_flags) {
+            // The line table refers to prog.asm next to prog.bin, if it is still there
+            source_default_path(argv[1], asm_path, sizeof(asm_path));
+            symtab_load(&syms, sym_path);
+            jit_set_perf(perf_flags, &syms, access(asm_path, R_OK) == 0 ? asm_path : NULL);
+        }
+        jit_func jitted_code = vm_compile(&vm);
+        jit_set_perf(0, NULL, NULL);
+        symtab_free(&syms);
         if (jitted_code) {
             // JIT returns the top of the stack as an integer
-            int result = jitted_code();
-            printf("JIT Result: %d\n", result);
+            int result;
+            if (vm_run_jit(&vm, jitted_code, &result) == 0) {
+                io_printf("JIT Result: %d\n", result);
+            }
+            print_gc_summary(&vm);
+            if (vm.gc_log) fclose(vm.gc_log);
+            free(vm.gc_records);
         } else {
             fprintf(stderr, "JIT Compilation Failed\n");
+            if (vm.gc_log) fclose(vm.gc_log);
+            free(code);
             return 1;
         }
     } else {
-        run_vm(&vm);
+        if (profile_path) {
+            vm.profile = profile_create(vm.code_size);
+            if (!vm.profile) {
+                fprintf(stderr, "Memory allocation failed\n");
+                if (vm.gc_log) fclose(vm.gc_log);
+                free(code);
+                return 1;
+            }
+        }
+
+        if (restore_path) {
+            vm_reset(&vm);
+            if (vm_snapshot_restore(&vm, restore_path) != 0) {
+                if (vm.gc_log) fclose(vm.gc_log);
+                profile_free(vm.profile);
+                free(code);
+                return 1;
+            }
+            vm_execute(&vm);
+        } else {
+            run_vm(&vm);
+        }
         
         if (!vm.error && vm.sp >= 0)
-            printf("Top of stack: %d\n", vm.stack[vm.sp]);
+            io_printf("Top of stack: %d\n", vm.stack[vm.sp]);
         else if (!vm.error)
-            printf("Stack empty\n");
+            io_printf("Stack empty\n");
 
-        if (vm.stats_gc_runs > 0) {
-            printf("[GC Stats] Runs: %d, Freed: %d, Total GC Time: %.6fs, Max Heap: %d words\n", 
-                vm.stats_gc_runs, vm.stats_freed_objects, vm.stats_total_gc_time, vm.stats_max_heap_used);
+        print_gc_summary(&vm);
+        if (vm.gc_log) fclose(vm.gc_log);
+        free(vm.gc_records);
+
+        if (vm.profile) {
+            // Labels are optional: without a .sym file the report falls back to raw pcs
+            SymTab syms;
+            symtab_load(&syms, sym_path);
+            io_flush();
+            profile_report(vm.profile, code, &syms, stderr, 10);
+            if (profile_write_json(vm.profile, code, &syms, profile_path) != 0) {
+                fprintf(stderr, "Error writing profile %s\n", profile_path);
+            } else {
+                fprintf(stderr, "\nProfile written to %s\n", profile_path);
+            }
+            symtab_free(&syms);
+            profile_free(vm.profile);
         }
     }
 
+    io_flush();
     free(code);
     return vm.error ? 1 : 0;
-}
\ No newline at end of file
+}
+
+#endif // AOT_RUNTIME